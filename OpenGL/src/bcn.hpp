@@ -0,0 +1,600 @@
+#ifndef BCN_H
+#define BCN_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "jobs.hpp"
+#include "simd.hpp"
+
+// S3TC is an extension rather than core, so the core profile glad.h leaves its enums out
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+// BC1 opaque colour at 4 bits a texel, BC3 colour plus alpha, BC4 one channel, BC5 two (normal maps), BC7 RGBA at 8 bits
+enum class BcnFormat : uint32_t { BC1, BC3, BC4, BC5, BC7 };
+
+const char* bcnFormatName(BcnFormat format) {
+    static const char* names[] = { "BC1", "BC3", "BC4", "BC5", "BC7" };
+    return names[(int)format];
+}
+
+size_t bcnBlockBytes(BcnFormat format) { return format == BcnFormat::BC1 || format == BcnFormat::BC4 ? 8 : 16; }
+
+size_t bcnLevelBytes(BcnFormat format, int width, int height) { return (size_t)((width + 3) / 4) * ((height + 3) / 4) * bcnBlockBytes(format); }
+
+// BC4 and BC5 have no sRGB variant, the flag is ignored for them
+GLenum bcnGLFormat(BcnFormat format, bool srgb) {
+    switch (format) {
+    case BcnFormat::BC1: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case BcnFormat::BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BcnFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+    case BcnFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+    default: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+}
+
+// 4x4 texels as floats, one row of 16 per channel so the palette search can take four texels at a time
+struct BcnBlock {
+    alignas(16) float c[4][16];
+};
+
+// edge blocks of sizes that are not a multiple of 4 repeat the last column and row
+void bcnLoadBlock(const uint8_t* rgba, int width, int height, int bx, int by, BcnBlock& block) {
+    for (int y = 0; y < 4; y++) {
+        const uint8_t* row = rgba + (size_t)std::min(by * 4 + y, height - 1) * width * 4;
+        for (int x = 0; x < 4; x++) {
+            const uint8_t* texel = row + std::min(bx * 4 + x, width - 1) * 4;
+            for (int c = 0; c < 4; c++) block.c[c][y * 4 + x] = texel[c];
+        }
+    }
+}
+
+#ifdef SIMD_SSE
+// false forces the scalar palette search, for benchmarking
+bool bcnSimd = true;
+#else
+bool bcnSimd = false;
+#endif
+
+// nearest palette entry of every texel over the first channels channels, returns the summed squared error
+float bcnNearestScalar(const BcnBlock& block, const float (*palette)[4], int count, int channels, uint8_t* indices) {
+    float total = 0.0f;
+    for (int i = 0; i < 16; i++) {
+        float best = FLT_MAX;
+        int bestIndex = 0;
+        for (int k = 0; k < count; k++) {
+            float d = 0.0f;
+            for (int c = 0; c < channels; c++) {
+                float diff = block.c[c][i] - palette[k][c];
+                d += diff * diff;
+            }
+            if (d < best) {
+                best = d;
+                bestIndex = k;
+            }
+        }
+        indices[i] = (uint8_t)bestIndex;
+        total += best;
+    }
+    return total;
+}
+
+#ifdef SIMD_SSE
+float bcnNearestSSE(const BcnBlock& block, const float (*palette)[4], int count, int channels, uint8_t* indices) {
+    __m128 total = _mm_setzero_ps();
+    for (int i = 0; i < 16; i += 4) {
+        __m128 texel[4];
+        for (int c = 0; c < channels; c++) texel[c] = _mm_load_ps(&block.c[c][i]);
+        __m128 best = _mm_set1_ps(FLT_MAX), bestIndex = _mm_setzero_ps();
+        for (int k = 0; k < count; k++) {
+            __m128 d = _mm_setzero_ps();
+            for (int c = 0; c < channels; c++) {
+                __m128 diff = _mm_sub_ps(texel[c], _mm_set1_ps(palette[k][c]));
+                d = _mm_add_ps(d, _mm_mul_ps(diff, diff));
+            }
+            __m128 closer = _mm_cmplt_ps(d, best);
+            best = _mm_min_ps(d, best);
+            bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps((float)k)), _mm_andnot_ps(closer, bestIndex));
+        }
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128((__m128i*)lanes, _mm_cvttps_epi32(bestIndex));
+        for (int j = 0; j < 4; j++) indices[i + j] = (uint8_t)lanes[j];
+        total = _mm_add_ps(total, best);
+    }
+    alignas(16) float sums[4];
+    _mm_store_ps(sums, total);
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+#endif
+
+float bcnNearest(const BcnBlock& block, const float (*palette)[4], int count, int channels, uint8_t* indices) {
+#ifdef SIMD_SSE
+    if (bcnSimd) return bcnNearestSSE(block, palette, count, channels, indices);
+#endif
+    return bcnNearestScalar(block, palette, count, channels, indices);
+}
+
+// extremes of the texels projected on the principal axis of their covariance, found by power iteration
+void bcnPrincipalEndpoints(const BcnBlock& block, int channels, float lo[4], float hi[4]) {
+    float mean[4] = {}, cov[4][4] = {};
+    for (int c = 0; c < channels; c++) {
+        for (int i = 0; i < 16; i++) mean[c] += block.c[c][i];
+        mean[c] /= 16.0f;
+    }
+    for (int i = 0; i < 16; i++)
+        for (int a = 0; a < channels; a++)
+            for (int b = a; b < channels; b++) cov[a][b] += (block.c[a][i] - mean[a]) * (block.c[b][i] - mean[b]);
+    float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[4] = {}, length = 0.0f;
+        for (int a = 0; a < channels; a++)
+            for (int b = 0; b < channels; b++) next[a] += (a <= b ? cov[a][b] : cov[b][a]) * axis[b];
+        for (int a = 0; a < channels; a++) length = std::max(length, std::fabs(next[a]));
+        if (length < 1e-6f) break;
+        for (int a = 0; a < channels; a++) axis[a] = next[a] / length;
+    }
+    float tMin = FLT_MAX, tMax = -FLT_MAX;
+    for (int i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for (int c = 0; c < channels; c++) t += (block.c[c][i] - mean[c]) * axis[c];
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    float norm = 0.0f;
+    for (int c = 0; c < channels; c++) norm += axis[c] * axis[c];
+    norm = norm > 0.0f ? 1.0f / norm : 0.0f;
+    for (int c = 0; c < channels; c++) {
+        lo[c] = std::min(std::max(mean[c] + axis[c] * tMin * norm, 0.0f), 255.0f);
+        hi[c] = std::min(std::max(mean[c] + axis[c] * tMax * norm, 0.0f), 255.0f);
+    }
+}
+
+// least squares endpoints for fixed indices, weights[k] is how far palette entry k sits from e0 towards e1.
+// false when every texel picked the same weight and the system is singular.
+bool bcnRefineEndpoints(const BcnBlock& block, int channels, const uint8_t* indices, const float* weights, float e0[4], float e1[4]) {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[4] = {}, bx[4] = {};
+    for (int i = 0; i < 16; i++) {
+        float b = weights[indices[i]], a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < channels; c++) {
+            ax[c] += a * block.c[c][i];
+            bx[c] += b * block.c[c][i];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f) return false;
+    for (int c = 0; c < channels; c++) {
+        e0[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / det, 0.0f), 255.0f);
+        e1[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / det, 0.0f), 255.0f);
+    }
+    return true;
+}
+
+uint16_t bcnPack565(const float rgb[3]) {
+    int r = (int)(rgb[0] * 31.0f / 255.0f + 0.5f), g = (int)(rgb[1] * 63.0f / 255.0f + 0.5f), b = (int)(rgb[2] * 31.0f / 255.0f + 0.5f);
+    return (uint16_t)(r << 11 | g << 5 | b);
+}
+
+void bcnUnpack565(uint16_t c, float rgb[4]) {
+    int r = c >> 11, g = (c >> 5) & 63, b = c & 31;
+    rgb[0] = (float)(r << 3 | r >> 2);
+    rgb[1] = (float)(g << 2 | g >> 4);
+    rgb[2] = (float)(b << 3 | b >> 2);
+    rgb[3] = 255.0f;
+}
+
+// four colour BC1 palette of c0 > c1
+void bcnColorPalette(uint16_t c0, uint16_t c1, float palette[4][4]) {
+    bcnUnpack565(c0, palette[0]);
+    bcnUnpack565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+        palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+    }
+    palette[2][3] = palette[3][3] = 255.0f;
+}
+
+// colour half of BC1 and BC3, always in four colour mode so it means the same in both
+void bcnEncodeColor(const BcnBlock& block, uint8_t* out) {
+    static const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+    float lo[4], hi[4];
+    bcnPrincipalEndpoints(block, 3, lo, hi);
+    uint16_t c0 = bcnPack565(hi), c1 = bcnPack565(lo);
+    uint8_t indices[16] = {};
+    float bestError = FLT_MAX;
+    uint16_t best0 = c0, best1 = c1;
+    uint8_t bestIndices[16] = {};
+    for (int pass = 0; pass < 2 && c0 != c1; pass++) {
+        if (c0 < c1) std::swap(c0, c1);
+        float palette[4][4];
+        bcnColorPalette(c0, c1, palette);
+        float error = bcnNearest(block, palette, 4, 3, indices);
+        if (error < bestError) {
+            bestError = error;
+            best0 = c0;
+            best1 = c1;
+            memcpy(bestIndices, indices, 16);
+        }
+        float e0[4], e1[4];
+        if (!bcnRefineEndpoints(block, 3, indices, weights, e0, e1)) break;
+        c0 = bcnPack565(e0);
+        c1 = bcnPack565(e1);
+    }
+    uint32_t bits = 0;
+    if (best0 != best1)
+        for (int i = 0; i < 16; i++) bits |= (uint32_t)bestIndices[i] << (2 * i);
+    out[0] = (uint8_t)best0;
+    out[1] = (uint8_t)(best0 >> 8);
+    out[2] = (uint8_t)best1;
+    out[3] = (uint8_t)(best1 >> 8);
+    memcpy(out + 4, &bits, 4);
+}
+
+// one channel of BC3 alpha, BC4 or BC5, in the eight value mode (e0 > e1)
+void bcnEncodeChannel(const BcnBlock& block, int channel, uint8_t* out) {
+    static const float weights[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+    BcnBlock single;
+    memcpy(single.c[0], block.c[channel], sizeof(single.c[0]));
+    float lo = 255.0f, hi = 0.0f;
+    for (int i = 0; i < 16; i++) {
+        lo = std::min(lo, single.c[0][i]);
+        hi = std::max(hi, single.c[0][i]);
+    }
+    int e0 = (int)hi, e1 = (int)lo;
+    uint8_t indices[16] = {}, bestIndices[16] = {};
+    int best0 = e0, best1 = e1;
+    float bestError = FLT_MAX;
+    for (int pass = 0; pass < 2 && e0 > e1; pass++) {
+        float palette[8][4] = {};
+        for (int k = 0; k < 8; k++) palette[k][0] = std::floor(((1.0f - weights[k]) * e0 + weights[k] * e1) + 0.5f);
+        float error = bcnNearest(single, palette, 8, 1, indices);
+        if (error < bestError) {
+            bestError = error;
+            best0 = e0;
+            best1 = e1;
+            memcpy(bestIndices, indices, 16);
+        }
+        float r0[4], r1[4];
+        if (!bcnRefineEndpoints(single, 1, indices, weights, r0, r1)) break;
+        e0 = (int)(r0[0] + 0.5f);
+        e1 = (int)(r1[0] + 0.5f);
+    }
+    uint64_t bits = 0;
+    if (best0 > best1)
+        for (int i = 0; i < 16; i++) bits |= (uint64_t)bestIndices[i] << (3 * i);
+    out[0] = (uint8_t)best0;
+    out[1] = (uint8_t)best1;
+    for (int i = 0; i < 6; i++) out[2 + i] = (uint8_t)(bits >> (8 * i));
+}
+
+const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// BC7 mode 6 endpoint: 7 bits a channel plus one p-bit shared by its four channels
+struct Bc7Endpoint {
+    int q[4];
+    int p;
+
+    void value(float out[4]) const {
+        for (int c = 0; c < 4; c++) out[c] = (float)(q[c] << 1 | p);
+    }
+};
+
+Bc7Endpoint bc7Quantize(const float e[4]) {
+    Bc7Endpoint best = {};
+    float bestError = FLT_MAX;
+    for (int p = 0; p < 2; p++) {
+        Bc7Endpoint candidate;
+        candidate.p = p;
+        float error = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            candidate.q[c] = std::min(std::max((int)std::floor((e[c] - p) / 2.0f + 0.5f), 0), 127);
+            float diff = (float)(candidate.q[c] << 1 | p) - e[c];
+            error += diff * diff;
+        }
+        if (error < bestError) {
+            bestError = error;
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+void bc7Palette(const Bc7Endpoint& a, const Bc7Endpoint& b, float palette[16][4]) {
+    float va[4], vb[4];
+    a.value(va);
+    b.value(vb);
+    for (int k = 0; k < 16; k++)
+        for (int c = 0; c < 4; c++) palette[k][c] = (float)(((64 - BC7_WEIGHTS4[k]) * (int)va[c] + BC7_WEIGHTS4[k] * (int)vb[c] + 32) >> 6);
+}
+
+// little endian bit stream of one 128 bit block
+struct BcnBits {
+    uint8_t* out;
+    int position = 0;
+
+    void write(uint32_t value, int count) {
+        for (int i = 0; i < count; i++, position++)
+            if (value >> i & 1) out[position >> 3] |= (uint8_t)(1 << (position & 7));
+    }
+};
+
+// mode 6 only: one subset, RGBA endpoints and 4 bit indices, good for the smooth colour of photos and albedo maps
+void bcnEncodeBC7(const BcnBlock& block, uint8_t* out) {
+    float weights[16];
+    for (int k = 0; k < 16; k++) weights[k] = BC7_WEIGHTS4[k] / 64.0f;
+    float lo[4], hi[4];
+    bcnPrincipalEndpoints(block, 4, lo, hi);
+    Bc7Endpoint e0 = bc7Quantize(lo), e1 = bc7Quantize(hi), best0 = e0, best1 = e1;
+    uint8_t indices[16], bestIndices[16] = {};
+    float bestError = FLT_MAX;
+    for (int pass = 0; pass < 2; pass++) {
+        float palette[16][4];
+        bc7Palette(e0, e1, palette);
+        float error = bcnNearest(block, palette, 16, 4, indices);
+        if (error < bestError) {
+            bestError = error;
+            best0 = e0;
+            best1 = e1;
+            memcpy(bestIndices, indices, 16);
+        }
+        float r0[4], r1[4];
+        if (!bcnRefineEndpoints(block, 4, indices, weights, r0, r1)) break;
+        e0 = bc7Quantize(r0);
+        e1 = bc7Quantize(r1);
+    }
+    // the first index is stored without its top bit, so it has to be below 8
+    if (bestIndices[0] >= 8) {
+        std::swap(best0, best1);
+        for (uint8_t& index : bestIndices) index = (uint8_t)(15 - index);
+    }
+    memset(out, 0, 16);
+    BcnBits bits = { out };
+    bits.write(1 << 6, 7);
+    for (int c = 0; c < 4; c++) {
+        bits.write(best0.q[c], 7);
+        bits.write(best1.q[c], 7);
+    }
+    bits.write(best0.p, 1);
+    bits.write(best1.p, 1);
+    bits.write(bestIndices[0], 3);
+    for (int i = 1; i < 16; i++) bits.write(bestIndices[i], 4);
+}
+
+void bcnEncodeBlock(BcnFormat format, const BcnBlock& block, uint8_t* out) {
+    switch (format) {
+    case BcnFormat::BC1: bcnEncodeColor(block, out); break;
+    case BcnFormat::BC3:
+        bcnEncodeChannel(block, 3, out);
+        bcnEncodeColor(block, out + 8);
+        break;
+    case BcnFormat::BC4: bcnEncodeChannel(block, 0, out); break;
+    case BcnFormat::BC5:
+        bcnEncodeChannel(block, 0, out);
+        bcnEncodeChannel(block, 1, out + 8);
+        break;
+    case BcnFormat::BC7: bcnEncodeBC7(block, out); break;
+    }
+}
+
+// one RGBA8 level into blocks, block rows spread over the job system
+void bcnEncodeLevel(JobSystem& jobs, BcnFormat format, const uint8_t* rgba, int width, int height, uint8_t* out) {
+    int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+    size_t blockBytes = bcnBlockBytes(format);
+    jobs.parallelFor(blocksHigh, 4, [&](size_t first, size_t last) {
+        BcnBlock block;
+        for (size_t by = first; by < last; by++)
+            for (int bx = 0; bx < blocksWide; bx++) {
+                bcnLoadBlock(rgba, width, height, bx, (int)by, block);
+                bcnEncodeBlock(format, block, out + (by * blocksWide + bx) * blockBytes);
+            }
+    }, "bcnEncode");
+}
+
+// decoders for contexts without the format, they write whole 4x4 RGBA8 blocks with a stride of 16 bytes a row
+
+void bcnDecodeColor(const uint8_t* in, uint8_t* out) {
+    uint16_t c0 = (uint16_t)(in[0] | in[1] << 8), c1 = (uint16_t)(in[2] | in[3] << 8);
+    float palette[4][4];
+    bcnColorPalette(c0, c1, palette);
+    if (c0 <= c1) {
+        for (int c = 0; c < 3; c++) palette[2][c] = (palette[0][c] + palette[1][c]) / 2.0f;
+        palette[3][0] = palette[3][1] = palette[3][2] = palette[3][3] = 0.0f;
+    }
+    uint32_t bits;
+    memcpy(&bits, in + 4, 4);
+    for (int i = 0; i < 16; i++) {
+        const float* color = palette[bits >> (2 * i) & 3];
+        for (int c = 0; c < 4; c++) out[i * 4 + c] = (uint8_t)(color[c] + 0.5f);
+    }
+}
+
+void bcnDecodeChannel(const uint8_t* in, int channel, uint8_t* out) {
+    int e0 = in[0], e1 = in[1];
+    int palette[8] = { e0, e1 };
+    for (int k = 2; k < 8; k++)
+        palette[k] = e0 > e1 ? ((8 - k) * e0 + (k - 1) * e1 + 3) / 7 : k < 6 ? ((6 - k) * e0 + (k - 1) * e1 + 2) / 5 : k == 6 ? 0 : 255;
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; i++) bits |= (uint64_t)in[2 + i] << (8 * i);
+    for (int i = 0; i < 16; i++) out[i * 4 + channel] = (uint8_t)palette[bits >> (3 * i) & 7];
+}
+
+// every BC7 mode as the spec lists them, for the decoder: subsets, partition, rotation and index selection bits,
+// colour and alpha bits per endpoint, p-bits per endpoint or per subset, then the bits of each index set
+struct Bc7Mode {
+    int subsets, partitionBits, rotationBits, selectionBits, colorBits, alphaBits, endpointPBits, sharedPBits, indexBits, index2Bits;
+};
+
+const Bc7Mode BC7_MODES[8] = {
+    { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 }, { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 }, { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 }, { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+    { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 }, { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 }, { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 }, { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+};
+
+const int BC7_WEIGHTS2[4] = { 0, 21, 43, 64 };
+const int BC7_WEIGHTS3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+
+// two subset partitions, bit i is the subset of texel i
+const uint16_t BC7_PARTITIONS2[64] = {
+    0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80, 0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+    0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce, 0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+    0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a, 0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+    0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c, 0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22
+};
+
+// three subset partitions, two bits a texel from texel 0 up
+const uint32_t BC7_PARTITIONS3[64] = {
+    0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8, 0xa5a50000, 0xa0a05050, 0x5555a0a0, 0x5a5a5050,
+    0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090, 0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250,
+    0xa5945040, 0x0a425054, 0xa5a5a500, 0x55a0a0a0, 0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+    0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400, 0xa08585a0, 0xaa821414, 0x50a4a450, 0x6a5a0200,
+    0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424, 0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50,
+    0x500aa550, 0xaaaa4444, 0x66660000, 0xa5a0a5a0, 0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+    0xaa444444, 0x54a854a8, 0x95809580, 0x96969600, 0xa85454a8, 0x80959580, 0xaa141414, 0x96960000,
+    0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000, 0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254
+};
+
+// texels that store their index one bit short: texel 0, then the first of the second and third subsets
+const uint8_t BC7_ANCHORS2[64] = {
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+    15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6, 6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+};
+const uint8_t BC7_ANCHORS3A[64] = {
+    3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3, 3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+    8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15, 3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3
+};
+const uint8_t BC7_ANCHORS3B[64] = {
+    15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8, 15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+    15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8, 15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8
+};
+
+int bc7Interpolate(int a, int b, int index, int bits) {
+    int w = bits == 2 ? BC7_WEIGHTS2[index] : bits == 3 ? BC7_WEIGHTS3[index] : BC7_WEIGHTS4[index];
+    return ((64 - w) * a + w * b + 32) >> 6;
+}
+
+// any BC7 block. The reserved mode, no mode bit in the first byte, decodes to transparent black and returns false.
+bool bcnDecodeBC7(const uint8_t* in, uint8_t* out) {
+    int mode = 0;
+    while (mode < 8 && !(in[0] >> mode & 1)) mode++;
+    if (mode == 8) {
+        memset(out, 0, 64);
+        return false;
+    }
+    const Bc7Mode& m = BC7_MODES[mode];
+    int position = mode + 1;
+    auto read = [&](int count) {
+        uint32_t value = 0;
+        for (int i = 0; i < count; i++, position++) value |= (uint32_t)(in[position >> 3] >> (position & 7) & 1) << i;
+        return (int)value;
+    };
+    int partition = read(m.partitionBits), rotation = read(m.rotationBits), selection = read(m.selectionBits);
+    int endpoints[6][4], count = m.subsets * 2;
+    for (int c = 0; c < 3; c++)
+        for (int e = 0; e < count; e++) endpoints[e][c] = read(m.colorBits);
+    for (int e = 0; e < count; e++) endpoints[e][3] = read(m.alphaBits);
+    int colorBits = m.colorBits, alphaBits = m.alphaBits;
+    if (m.endpointPBits || m.sharedPBits) {
+        int pbits[6];
+        for (int e = 0; e < count; e++) pbits[e] = m.endpointPBits || e % 2 == 0 ? read(1) : pbits[e - 1];
+        for (int e = 0; e < count; e++)
+            for (int c = 0; c < 4; c++) endpoints[e][c] = endpoints[e][c] << 1 | pbits[e];
+        colorBits++;
+        if (alphaBits) alphaBits++;
+    }
+    // to 8 bits by repeating the top bits into the bottom
+    for (int e = 0; e < count; e++) {
+        for (int c = 0; c < 3; c++) endpoints[e][c] = endpoints[e][c] << (8 - colorBits) | endpoints[e][c] >> (2 * colorBits - 8);
+        endpoints[e][3] = alphaBits ? endpoints[e][3] << (8 - alphaBits) | endpoints[e][3] >> (2 * alphaBits - 8) : 255;
+    }
+
+    int subset[16], indices[16], indices2[16] = {};
+    for (int i = 0; i < 16; i++) {
+        subset[i] = m.subsets == 2 ? BC7_PARTITIONS2[partition] >> i & 1 : m.subsets == 3 ? BC7_PARTITIONS3[partition] >> (2 * i) & 3 : 0;
+        bool anchor = i == 0 || (m.subsets == 2 && i == BC7_ANCHORS2[partition]) ||
+                      (m.subsets == 3 && (i == BC7_ANCHORS3A[partition] || i == BC7_ANCHORS3B[partition]));
+        indices[i] = read(m.indexBits - anchor);
+    }
+    if (m.index2Bits)
+        for (int i = 0; i < 16; i++) indices2[i] = read(m.index2Bits - (i == 0));
+
+    for (int i = 0; i < 16; i++) {
+        const int* a = endpoints[subset[i] * 2];
+        const int* b = endpoints[subset[i] * 2 + 1];
+        // modes 4 and 5 weigh colour and alpha with separate index sets, the selection bit swaps which is which
+        int colorIndex = indices[i], colorIndexBits = m.indexBits, alphaIndex = indices[i], alphaIndexBits = m.indexBits;
+        if (m.index2Bits) {
+            alphaIndex = indices2[i];
+            alphaIndexBits = m.index2Bits;
+            if (selection) {
+                std::swap(colorIndex, alphaIndex);
+                std::swap(colorIndexBits, alphaIndexBits);
+            }
+        }
+        uint8_t* texel = out + i * 4;
+        for (int c = 0; c < 3; c++) texel[c] = (uint8_t)bc7Interpolate(a[c], b[c], colorIndex, colorIndexBits);
+        texel[3] = (uint8_t)bc7Interpolate(a[3], b[3], alphaIndex, alphaIndexBits);
+        if (rotation) std::swap(texel[3], texel[rotation - 1]);
+    }
+    return true;
+}
+
+// PSNR of the channels a format keeps, both images RGBA8
+double bcnPsnr(BcnFormat format, const uint8_t* original, const uint8_t* decoded, size_t texels) {
+    int channels = format == BcnFormat::BC4 ? 1 : format == BcnFormat::BC5 ? 2 : format == BcnFormat::BC1 ? 3 : 4;
+    double error = 0.0;
+    for (size_t i = 0; i < texels; i++)
+        for (int c = 0; c < channels; c++) {
+            double diff = (double)original[i * 4 + c] - decoded[i * 4 + c];
+            error += diff * diff;
+        }
+    error /= (double)texels * channels;
+    return error > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / error) : 99.0;
+}
+
+// blocks back to RGBA8, one channel formats leave the others at 0 and alpha at 255 like sampling GL_RED or GL_RG would
+bool bcnDecodeLevel(BcnFormat format, const uint8_t* blocks, int width, int height, uint8_t* rgba) {
+    int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+    size_t blockBytes = bcnBlockBytes(format);
+    bool ok = true;
+    uint8_t texels[64];
+    for (int by = 0; by < blocksHigh; by++)
+        for (int bx = 0; bx < blocksWide; bx++) {
+            const uint8_t* in = blocks + ((size_t)by * blocksWide + bx) * blockBytes;
+            memset(texels, 0, sizeof(texels));
+            for (int i = 0; i < 16; i++) texels[i * 4 + 3] = 255;
+            switch (format) {
+            case BcnFormat::BC1: bcnDecodeColor(in, texels); break;
+            case BcnFormat::BC3:
+                bcnDecodeColor(in + 8, texels);
+                bcnDecodeChannel(in, 3, texels);
+                break;
+            case BcnFormat::BC4: bcnDecodeChannel(in, 0, texels); break;
+            case BcnFormat::BC5:
+                bcnDecodeChannel(in, 0, texels);
+                bcnDecodeChannel(in + 8, 1, texels);
+                break;
+            case BcnFormat::BC7: ok &= bcnDecodeBC7(in, texels); break;
+            }
+            for (int y = 0; y < 4 && by * 4 + y < height; y++)
+                for (int x = 0; x < 4 && bx * 4 + x < width; x++)
+                    memcpy(rgba + (((size_t)by * 4 + y) * width + bx * 4 + x) * 4, texels + (y * 4 + x) * 4, 4);
+        }
+    return ok;
+}
+
+#endif
\ No newline at end of file
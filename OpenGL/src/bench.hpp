@@ -0,0 +1,1262 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <glad/glad.h>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <cstdio>
+#include <sys/resource.h>
+#include <string>
+#include <vector>
+#include "camera.hpp"
+#include "shader.hpp"
+#include "samples.hpp"
+#include "objLoader.hpp"
+#include "meshFile.hpp"
+#include "textureCache.hpp"
+
+// everything a benchmark needs from the party scene set up in main
+struct BenchContext {
+    Camera& cam;
+    Shader& lightingShader;
+    Shader& lightSrcShader;
+    const Mesh& cube;
+    int frames;
+    unsigned int cubes;
+    const char* asset; // optional input file for the loader benchmarks
+};
+
+struct FrameStats {
+    double avgMs = 0.0, minMs = 0.0, maxMs = 0.0;
+};
+
+// times the CPU side of frame() only, the GPU is drained after each sample so queued work never leaks into the next one,
+// includeGpu moves the drain inside the timed region to measure the whole frame
+FrameStats timeFrames(int frames, const std::function<void()>& frame, bool includeGpu = false) {
+    std::vector<double> samples;
+    samples.reserve(frames);
+    for (int i = 0; i < frames; i++) {
+        auto start = std::chrono::steady_clock::now();
+        frame();
+        if (includeGpu) glFinish();
+        auto end = std::chrono::steady_clock::now();
+        if (!includeGpu) glFinish();
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    FrameStats stats;
+    if (samples.empty()) return stats;
+    for (double s : samples) stats.avgMs += s;
+    stats.avgMs /= samples.size();
+    stats.minMs = *std::min_element(samples.begin(), samples.end());
+    stats.maxMs = *std::max_element(samples.begin(), samples.end());
+    return stats;
+}
+
+void printFrameStats(const std::string& label, const FrameStats& stats) {
+    std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(4)
+              << " avg " << stats.avgMs << " ms  min " << stats.minMs << " ms  max " << stats.maxMs << " ms" << std::endl;
+}
+
+// the party cubes with per object uniforms set by name, the way the samples did before handles, once through
+// glGetUniformLocation and once through the reflected table, against handles resolved once a frame.
+// At least 1000 cubes with the rasterizer discarded so the per object cost is what shows.
+void benchUniformCache(BenchContext& ctx) {
+    unsigned int count = std::max(ctx.cubes, 1000u);
+    auto byName = [&]() {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        partyLights.sync();
+        ctx.cube.VAO.bind();
+        ctx.lightingShader.use();
+        glm::mat4 view = ctx.cam.getViewMatrix();
+        ctx.lightingShader.setMatrix("view", view);
+        ctx.lightingShader.setMatrix("projection", glm::perspective(glm::radians(ctx.cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f));
+        float time = (float)glfwGetTime();
+        for (unsigned int i = 0; i < count; i++) {
+            glm::mat4 modelView = view * partyModel(i, time);
+            ctx.lightingShader.setMatrix("modelView", modelView);
+            ctx.lightingShader.setMat3("normalMatrix", normalMatrix(modelView));
+            ctx.cube.draw();
+        }
+    };
+    auto handles = [&]() {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        drawPartyCL(ctx.cam, ctx.cube, ctx.lightingShader, count);
+    };
+    glState().enable(GL_RASTERIZER_DISCARD);
+    timeFrames(std::min(ctx.frames, 50), byName); // warm up driver caches
+    Shader::uniformCacheEnabled = false;
+    FrameStats uncached = timeFrames(ctx.frames, byName);
+    Shader::uniformCacheEnabled = true;
+    FrameStats cached = timeFrames(ctx.frames, byName);
+    FrameStats resolved = timeFrames(ctx.frames, handles);
+    glState().disable(GL_RASTERIZER_DISCARD);
+    std::cout << "party scene, " << count << " cubes, " << ctx.frames << " frames, " << ctx.lightingShader.uniformCount() << " reflected uniforms" << std::endl;
+    printFrameStats("glGetUniformLocation by name", uncached);
+    printFrameStats("reflected table by name", cached);
+    printFrameStats("handles once a frame", resolved);
+}
+
+// per-object uniform + glDrawArrays loop against one glDrawArraysInstanced, both at ctx.cubes cubes
+void benchInstancing(BenchContext& ctx) {
+    InstanceBuffer instances;
+    auto instanced = prepPartyCLInstanced(instances);
+    auto loop = [&]() {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        drawPartyCL(ctx.cam, ctx.cube, ctx.lightingShader, ctx.cubes);
+    };
+    auto single = [&]() {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        drawPartyCLInstanced(ctx.cam, instanced.second, instanced.first, instances, ctx.cubes);
+    };
+    timeFrames(std::min(ctx.frames, 10), loop);
+    FrameStats loopStats = timeFrames(ctx.frames, loop);
+    timeFrames(std::min(ctx.frames, 10), single);
+    FrameStats instancedStats = timeFrames(ctx.frames, single);
+    std::cout << "party scene, " << ctx.cubes << " cubes, " << ctx.frames << " frames" << std::endl;
+    printFrameStats("per-object loop (" + std::to_string(ctx.cubes) + " draws)", loopStats);
+    printFrameStats("instanced (1 draw)", instancedStats);
+}
+
+// vertex stage only: high-poly spheres with rasterization discarded, per-vertex inverse against CPU normal matrices
+void benchNormalMatrix(BenchContext& ctx) {
+    auto sphere = createSphereWithNormTex(256, 512);
+    Shader inverseShader("../src/shaders/fullVtxInverse.glsl", "../src/shaders/lightSrc.glsl");
+    Shader cpuShader("../src/shaders/fullVtx.glsl", "../src/shaders/lightSrc.glsl");
+    glm::mat4 view = ctx.cam.getViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(ctx.cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f);
+    const unsigned int spheres = 8;
+    auto perVertex = [&]() {
+        sphere.VAO.bind();
+        inverseShader.use();
+        inverseShader.setMatrix("view", view);
+        inverseShader.setMatrix("projection", projection);
+        UniformHandle modelLoc = inverseShader.uniform("model");
+        for (unsigned int i = 0; i < spheres; i++) {
+            inverseShader.setMatrix(modelLoc, partyModel(i, 0.0f));
+            sphere.draw();
+        }
+    };
+    auto perObject = [&]() {
+        sphere.VAO.bind();
+        cpuShader.use();
+        cpuShader.setMatrix("projection", projection);
+        ObjectTransform transform(cpuShader);
+        for (unsigned int i = 0; i < spheres; i++) {
+            transform.set(cpuShader, view, partyModel(i, 0.0f));
+            sphere.draw();
+        }
+    };
+    glState().enable(GL_RASTERIZER_DISCARD);
+    timeFrames(std::min(ctx.frames, 5), perVertex, true);
+    FrameStats inverseStats = timeFrames(ctx.frames, perVertex, true);
+    timeFrames(std::min(ctx.frames, 5), perObject, true);
+    FrameStats cpuStats = timeFrames(ctx.frames, perObject, true);
+    glState().disable(GL_RASTERIZER_DISCARD);
+    std::cout << spheres << " spheres x " << sphere.count << " vertices, " << ctx.frames << " frames, rasterizer discarded" << std::endl;
+    printFrameStats("inverse() per vertex", inverseStats);
+    printFrameStats("normal matrix per object", cpuStats);
+}
+
+// vertex welding report for the built-in soups, nothing is timed
+void benchMeshes(BenchContext&) {
+    MeshStats stats;
+    createMesh(defCube, sizeof(defCube), false, false, &stats);
+    printMeshStats("defCube", stats);
+    createMesh(defCubeWithNorm, sizeof(defCubeWithNorm), true, false, &stats);
+    printMeshStats("defCubeWithNorm", stats);
+    createMesh(defCubeWithNormTex, sizeof(defCubeWithNormTex), true, true, &stats);
+    printMeshStats("defCubeWithNormTex", stats);
+    std::vector<float> sphere = defSphereWithNormTex(256, 512);
+    createMesh(sphere.data(), sphere.size() * sizeof(float), true, true, &stats);
+    printMeshStats("sphere 256x512", stats);
+}
+
+void printCacheStats(const std::string& label, const VertexCacheStats& stats) {
+    std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(3)
+              << " ACMR " << stats.acmr << "  ATVR " << stats.atvr << std::endl;
+}
+
+// post-transform cache efficiency of a welded sphere as generated, shuffled like a badly exported asset, and optimized
+void benchVertexCache(BenchContext& ctx) {
+    std::vector<float> soup = defSphereWithNormTex(256, 512);
+    MeshBuilder builder(true, true);
+    builder.addTriangles(soup.data(), soup.size());
+    MeshData generated = builder.build();
+
+    MeshData shuffled = generated;
+    std::vector<unsigned int> order(shuffled.indices.size() / 3);
+    for (unsigned int i = 0; i < order.size(); i++) order[i] = i;
+    std::mt19937 rng(1234);
+    std::shuffle(order.begin(), order.end(), rng);
+    for (size_t i = 0; i < order.size(); i++)
+        for (int k = 0; k < 3; k++) shuffled.indices[i * 3 + k] = generated.indices[order[i] * 3 + k];
+
+    MeshData optimized = shuffled;
+    auto start = std::chrono::steady_clock::now();
+    optimizeMesh(optimized);
+    double optimizeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "sphere 256x512, " << generated.vertexCount() << " vertices, " << generated.indices.size() / 3 << " triangles, FIFO 16" << std::endl;
+    printCacheStats("generated order", analyzeVertexCache(generated.indices, generated.vertexCount()));
+    printCacheStats("shuffled", analyzeVertexCache(shuffled.indices, shuffled.vertexCount()));
+    printCacheStats("optimized", analyzeVertexCache(optimized.indices, optimized.vertexCount()));
+    std::cout << "optimizeMesh took " << optimizeMs << " ms" << std::endl;
+
+    // vertex stage cost of the shuffled and optimized orders, rasterization discarded
+    Mesh shuffledMesh = uploadMesh(shuffled), optimizedMesh = uploadMesh(optimized);
+    Shader shader("../src/shaders/fullVtx.glsl", "../src/shaders/lightSrc.glsl");
+    glm::mat4 view = ctx.cam.getViewMatrix();
+    auto drawWith = [&](const Mesh& mesh) {
+        return [&]() {
+            mesh.VAO.bind();
+            shader.use();
+            shader.setMatrix("projection", glm::perspective(glm::radians(ctx.cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f));
+            ObjectTransform transform(shader);
+            for (unsigned int i = 0; i < 8; i++) {
+                transform.set(shader, view, partyModel(i, 0.0f));
+                mesh.draw();
+            }
+        };
+    };
+    glState().enable(GL_RASTERIZER_DISCARD);
+    timeFrames(std::min(ctx.frames, 5), drawWith(shuffledMesh), true);
+    FrameStats shuffledStats = timeFrames(ctx.frames, drawWith(shuffledMesh), true);
+    timeFrames(std::min(ctx.frames, 5), drawWith(optimizedMesh), true);
+    FrameStats optimizedStats = timeFrames(ctx.frames, drawWith(optimizedMesh), true);
+    glState().disable(GL_RASTERIZER_DISCARD);
+    printFrameStats("8 spheres shuffled", shuffledStats);
+    printFrameStats("8 spheres optimized", optimizedStats);
+}
+
+// peak resident set of the process so far, in MB
+double peakRssMB() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0); // bytes on macOS
+#else
+    return usage.ru_maxrss / 1024.0; // kilobytes on Linux
+#endif
+}
+
+// an n x n grid with positions, uvs, normals and quad faces, roughly 125 bytes per grid vertex
+void writeGridObj(const char* path, int n) {
+    FILE* file = fopen(path, "w");
+    if (!file) return;
+    for (int y = 0; y < n; y++)
+        for (int x = 0; x < n; x++) fprintf(file, "v %.6f %.6f %.6f\n", (float)x / n, sinf(x * 0.1f) * cosf(y * 0.1f) * 0.05f, (float)y / n);
+    for (int y = 0; y < n; y++)
+        for (int x = 0; x < n; x++) fprintf(file, "vt %.6f %.6f\n", (float)x / (n - 1), (float)y / (n - 1));
+    for (int y = 0; y < n; y++)
+        for (int x = 0; x < n; x++) fprintf(file, "vn %.6f %.6f %.6f\n", 0.0f, 1.0f, 0.0f);
+    for (int y = 0; y + 1 < n; y++) {
+        for (int x = 0; x + 1 < n; x++) {
+            int a = y * n + x + 1, b = a + 1, c = a + n + 1, d = a + n;
+            fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, d, d, d, c, c, c, b, b, b);
+        }
+    }
+    fclose(file);
+}
+
+// parse throughput of loadObj on ctx.asset, or on a generated ~280 MB grid, single threaded and on every core
+void benchObjLoader(BenchContext& ctx) {
+    const char* path = ctx.asset ? ctx.asset : "bench.obj";
+    FILE* existing = fopen(path, "r");
+    if (existing) fclose(existing);
+    else {
+        std::cout << "writing " << path << "..." << std::endl;
+        writeGridObj(path, 1500);
+    }
+    double rssBefore = peakRssMB();
+    std::vector<unsigned int> threadCounts = { 1u };
+    if (std::thread::hardware_concurrency() > 1) threadCounts.push_back(std::thread::hardware_concurrency());
+    for (unsigned int threads : threadCounts) {
+        MeshData data;
+        ObjStats stats;
+        auto start = std::chrono::steady_clock::now();
+        if (!loadObj(path, data, &stats, threads)) return;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << threads << " thread(s): " << stats.bytes / (1024.0 * 1024.0) << " MB in " << seconds * 1000.0 << " ms, "
+                  << stats.bytes / (1024.0 * 1024.0) / seconds << " MB/s, " << stats.triangles << " triangles, "
+                  << stats.vertices << " welded vertices" << std::endl;
+    }
+    std::cout << "peak RSS " << peakRssMB() << " MB (" << rssBefore << " MB before loading)" << std::endl;
+}
+
+// load to GPU time of the OBJ text path against the cooked file of the same mesh, glFinish included in both
+void benchCookedMesh(BenchContext& ctx) {
+    const char* objPath = ctx.asset ? ctx.asset : "bench.obj";
+    FILE* existing = fopen(objPath, "r");
+    if (existing) fclose(existing);
+    else {
+        std::cout << "writing " << objPath << "..." << std::endl;
+        writeGridObj(objPath, 1500);
+    }
+    std::string cookedPath = std::string(objPath) + ".mesh";
+    MeshData data;
+    if (!loadObj(objPath, data)) return;
+    optimizeMesh(data);
+    if (!writeMeshFile(cookedPath.c_str(), data)) return;
+    data = MeshData();
+
+    Mesh mesh;
+    if (!loadMeshFile(cookedPath.c_str(), mesh)) return;
+    mesh = Mesh();
+    FrameStats text = timeFrames(3, [&]() {
+        createObjMesh(objPath, mesh);
+        mesh = Mesh();
+    }, true);
+    FrameStats cooked = timeFrames(3, [&]() {
+        loadMeshFile(cookedPath.c_str(), mesh);
+        mesh = Mesh();
+    }, true);
+    printFrameStats("obj text load", text);
+    printFrameStats("cooked mesh load", cooked);
+    std::cout << "cooked load is " << text.minMs / cooked.minMs << "x faster (" << cookedPath << ")" << std::endl;
+}
+
+// precision report for the quantized layout, then vertex stage cost of float against quantized attributes
+void benchQuantize(BenchContext& ctx) {
+    MeshBuilder cubeBuilder(true, true);
+    cubeBuilder.addTriangles(defCubeWithNormTex, sizeof(defCubeWithNormTex) / sizeof(float));
+    printQuantizationError("cube", measureQuantization(cubeBuilder.build(), quantizeVertices(cubeBuilder.build())));
+
+    std::vector<float> soup = defSphereWithNormTex(256, 512);
+    MeshBuilder builder(true, true);
+    builder.addTriangles(soup.data(), soup.size());
+    MeshData sphere = builder.build();
+    optimizeMesh(sphere);
+    QuantizationError sphereError;
+    Mesh quantizedMesh = uploadQuantizedMesh(sphere, &sphereError);
+    Mesh floatMesh = uploadMesh(sphere);
+    printQuantizationError("sphere 256x512", sphereError);
+
+    if (ctx.asset) {
+        MeshData asset;
+        if (loadObj(ctx.asset, asset)) printQuantizationError(ctx.asset, measureQuantization(asset, quantizeVertices(asset)));
+    }
+
+    // the quantized shader with an identity decode draws the float mesh too, so only the fetch differs
+    Shader shader("../src/shaders/fullVtxQuantized.glsl", "../src/shaders/lightSrc.glsl");
+    glm::mat4 view = ctx.cam.getViewMatrix();
+    auto drawWith = [&](const Mesh& mesh) {
+        return [&]() {
+            mesh.VAO.bind();
+            shader.use();
+            shader.setMatrix("projection", glm::perspective(glm::radians(ctx.cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f));
+            setVertexDecode(shader, mesh.decode);
+            ObjectTransform transform(shader);
+            for (unsigned int i = 0; i < 8; i++) {
+                transform.set(shader, view, partyModel(i, 0.0f));
+                mesh.draw();
+            }
+        };
+    };
+    glState().enable(GL_RASTERIZER_DISCARD);
+    timeFrames(std::min(ctx.frames, 5), drawWith(floatMesh), true);
+    FrameStats floatStats = timeFrames(ctx.frames, drawWith(floatMesh), true);
+    timeFrames(std::min(ctx.frames, 5), drawWith(quantizedMesh), true);
+    FrameStats quantizedStats = timeFrames(ctx.frames, drawWith(quantizedMesh), true);
+    glState().disable(GL_RASTERIZER_DISCARD);
+    printFrameStats("8 spheres float", floatStats);
+    printFrameStats("8 spheres quantized", quantizedStats);
+}
+
+// party scene with the state cache on and off, plus a naive variant that rebinds program, VAO and material per cube
+void benchStateCache(BenchContext& ctx) {
+    auto draw = [&](bool rebind) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        drawPtLights(ctx.cam, ctx.cube, ctx.lightSrcShader);
+        drawPartyCL(ctx.cam, ctx.cube, ctx.lightingShader, ctx.cubes, rebind);
+    };
+    auto party = [&]() { draw(false); };
+    auto naive = [&]() { draw(true); };
+    std::cout << "party scene, " << ctx.frames << " frames, " << ctx.cubes << " cubes" << std::endl;
+    for (auto& scene : { std::make_pair("party", std::function<void()>(party)), std::make_pair("naive binds", std::function<void()>(naive)) }) {
+        for (bool cached : { false, true }) {
+            glState().enabled = cached;
+            timeFrames(std::min(ctx.frames, 50), scene.second); // warm up
+            glState().newFrame();
+            FrameStats stats = timeFrames(ctx.frames, scene.second);
+            glState().newFrame();
+            const GLStateCache::Counters& counters = glState().lastFrame();
+            printFrameStats(std::string(scene.first) + (cached ? ", cached" : ", uncached"), stats);
+            std::cout << "    " << (double)counters.totalIssued() / ctx.frames << " issued, " << (double)counters.totalSkipped() / ctx.frames
+                      << " skipped state calls per frame" << std::endl;
+        }
+    }
+    glState().enabled = true;
+}
+
+// synthetic scene of thousands of objects over 4 programs, 16 materials and 4 meshes in random order,
+// drawn in submission order against a sorted RenderQueue, rasterizer discarded so only submission is measured
+void benchRenderQueue(BenchContext& ctx) {
+    unsigned int objects = std::max(ctx.cubes, 4096u);
+    Shader lit("../src/shaders/fullVtx.glsl", "../src/shaders/lightTypes/combined.glsl");
+    Shader unlit("../src/shaders/fullVtx.glsl", "../src/shaders/lightSrc.glsl");
+    Shader directional("../src/shaders/fullVtx.glsl", "../src/shaders/lightTypes/direction.glsl");
+    Shader flat("../src/shaders/fullVtx.glsl", "../src/shaders/lightObj.glsl");
+    partyLights.attach(lit);
+    Shader* shaders[] = { &lit, &unlit, &directional, &flat };
+    Mesh cubeA = createIndexedCubeWithNormTex(), cubeB = createIndexedCubeWithNormTex(), sphere;
+    {
+        std::vector<float> vertices = defSphereWithNormTex(16, 32);
+        sphere = createMesh(vertices.data(), vertices.size() * sizeof(float), true, true);
+    }
+    const Mesh* meshes[] = { &ctx.cube, &cubeA, &cubeB, &sphere };
+
+    // the same three images under two samplers, odd sets clamp and filter nearest
+    const Sampler* samplers[] = { partySampler, &samplerCache().get(SamplerDesc(GL_CLAMP_TO_EDGE, GL_NEAREST_MIPMAP_NEAREST, GL_NEAREST)) };
+    RenderQueue queue;
+    std::vector<Material> materials;
+    for (Shader* shader : shaders) {
+        for (int set = 0; set < 4; set++) {
+            Material material;
+            material.shader = shader;
+            for (int unit = 0; unit < 3; unit++) {
+                material.textures[unit] = partyMaps[(unit + set) % 3].get();
+                material.samplers[unit] = samplers[set % 2];
+            }
+            if (set == 3) material.textures[2] = partyMaps[set % 3].get();
+            if (shader == &unlit) material.colorUniform = "lightColor";
+            materials.push_back(material);
+            queue.addMaterial(material);
+        }
+    }
+    struct Object {
+        uint32_t material, mesh;
+        glm::mat4 model;
+    };
+    std::vector<Object> scene(objects);
+    std::mt19937 rng(42);
+    for (unsigned int i = 0; i < objects; i++)
+        scene[i] = { (uint32_t)(rng() % materials.size()), (uint32_t)(rng() % 4), partyModel(i, 0.0f) };
+
+    glm::mat4 view = ctx.cam.getViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(ctx.cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f);
+    auto callOrder = [&]() {
+        for (const Object& object : scene) {
+            const Material& material = materials[object.material];
+            material.shader->use();
+            material.shader->setMatrix("projection", projection);
+            for (int unit = 0; unit < 3; unit++) {
+                material.textures[unit]->bind(unit, GL_TEXTURE_2D);
+                material.samplers[unit]->bind(unit);
+            }
+            meshes[object.mesh]->VAO.bind();
+            ObjectTransform(*material.shader).set(*material.shader, view, object.model);
+            if (material.colorUniform) material.shader->setVec3(material.colorUniform, glm::vec3(1.0f));
+            meshes[object.mesh]->draw();
+        }
+    };
+    auto sorted = [&]() {
+        queue.begin(view, projection);
+        for (const Object& object : scene) queue.submit(RenderPass::Opaque, object.material, *meshes[object.mesh], object.model);
+        queue.flush();
+    };
+    size_t programChanges = 0, materialChanges = 0, meshChanges = 0;
+    for (unsigned int i = 0; i < objects; i++) {
+        const Object& prev = scene[i ? i - 1 : 0];
+        bool first = i == 0;
+        programChanges += first || materials[prev.material].shader != materials[scene[i].material].shader;
+        materialChanges += first || prev.material != scene[i].material;
+        meshChanges += first || prev.mesh != scene[i].mesh;
+    }
+
+    std::cout << objects << " objects, " << sizeof(shaders) / sizeof(shaders[0]) << " programs, " << materials.size() << " materials, 4 meshes, "
+              << ctx.frames << " frames, rasterizer discarded" << std::endl;
+    std::cout << "submission order changes per frame: " << programChanges << " programs, " << materialChanges << " materials, " << meshChanges << " meshes" << std::endl;
+    glState().enable(GL_RASTERIZER_DISCARD);
+    auto run = [&](const std::string& label, const std::function<void()>& frame, bool cached) {
+        glState().enabled = cached;
+        timeFrames(std::min(ctx.frames, 10), frame);
+        glState().newFrame();
+        FrameStats stats = timeFrames(ctx.frames, frame);
+        glState().newFrame();
+        printFrameStats(label, stats);
+        std::cout << "    " << glState().lastFrame().totalIssued() / ctx.frames << " GL state calls issued per frame" << std::endl;
+    };
+    run("call order, no state cache", callOrder, false);
+    run("call order, state cache", callOrder, true);
+    run("render queue", sorted, true);
+    RenderQueueStats stats = queue.stats();
+    std::cout << "render queue changes per frame: " << stats.programChanges << " programs, " << stats.materialChanges << " materials, "
+              << stats.meshChanges << " meshes for " << stats.draws << " draws" << std::endl;
+
+    // the same scene as one transparent pass, back to front across every program and material
+    auto blended = [&]() {
+        queue.begin(view, projection);
+        for (const Object& object : scene) queue.submit(RenderPass::Transparent, object.material, *meshes[object.mesh], object.model);
+        queue.flush();
+    };
+    run("render queue, transparent", blended, true);
+    glState().disable(GL_RASTERIZER_DISCARD);
+    stats = queue.stats();
+    auto distance = [&](size_t i) { return glm::clamp(-(view * queue.sorted(i).model[3]).z, 0.0f, 100.0f); };
+    size_t nearerFirst = 0;
+    for (size_t i = 1; i < queue.size(); i++) nearerFirst += distance(i) > distance(i - 1) + 100.0f / (1 << SORT_DEPTH_BITS);
+    std::cout << "transparent changes per frame: " << stats.programChanges << " programs, " << stats.materialChanges << " materials, "
+              << stats.meshChanges << " meshes for " << stats.draws << " draws, " << nearerFirst << " drawn before something farther" << std::endl;
+
+    // the sort alone, radix against std::sort on the same keys
+    std::vector<SortEntry> keys(objects), work, scratch;
+    for (unsigned int i = 0; i < objects; i++)
+        keys[i] = { makeSortKey(0, scene[i].material / 4, scene[i].material, scene[i].mesh, rng() & 0xfffff), i }; // 4 materials a program
+    FrameStats radix = timeFrames(ctx.frames, [&]() {
+        work = keys;
+        radixSort(work, scratch);
+    });
+    FrameStats comparison = timeFrames(ctx.frames, [&]() {
+        work = keys;
+        std::sort(work.begin(), work.end(), [](const SortEntry& a, const SortEntry& b) { return a.key < b.key; });
+    });
+    printFrameStats("radix sort", radix);
+    printFrameStats("std::sort", comparison);
+}
+
+// thousands of static objects over 4 meshes: a VAO and glDrawElements per mesh against one IndirectBatch drawn with a
+// glDrawElementsBaseVertex loop and with glMultiDrawElementsIndirect, rasterizer discarded so only submission is measured
+void benchIndirect(BenchContext& ctx) {
+    unsigned int objects = std::max(ctx.cubes, 4096u);
+    std::vector<float> spheres[3] = { defSphereWithNormTex(8, 16), defSphereWithNormTex(12, 24), defSphereWithNormTex(16, 32) };
+    Mesh separate[4];
+    IndirectBatch loopBatch, indirectBatch;
+    for (IndirectBatch* batch : { &loopBatch, &indirectBatch }) batch->addObj(defCubeWithNormTex, sizeof(defCubeWithNormTex));
+    separate[0] = createIndexedCubeWithNormTex();
+    for (int i = 0; i < 3; i++) {
+        separate[i + 1] = createMesh(spheres[i].data(), spheres[i].size() * sizeof(float), true, true);
+        for (IndirectBatch* batch : { &loopBatch, &indirectBatch }) batch->addObj(spheres[i].data(), spheres[i].size() * sizeof(float));
+    }
+    loopBatch.indirect = false;
+
+    std::vector<uint32_t> meshOf(objects);
+    std::mt19937 rng(42);
+    for (unsigned int i = 0; i < objects; i++) {
+        meshOf[i] = rng() % 4;
+        loopBatch.addDraw(meshOf[i], partyModel(i, 0.0f));
+        indirectBatch.addDraw(meshOf[i], partyModel(i, 0.0f));
+    }
+
+    Shader& lit = ctx.lightingShader;
+    glm::mat4 view = ctx.cam.getViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(ctx.cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f);
+    auto perMesh = [&]() {
+        lit.use();
+        lit.setMatrix("projection", projection);
+        ObjectTransform transform(lit);
+        for (unsigned int i = 0; i < objects; i++) {
+            const Mesh& mesh = separate[meshOf[i]];
+            mesh.VAO.bind();
+            transform.set(lit, view, partyModel(i, 0.0f));
+            mesh.draw();
+        }
+    };
+    auto loop = [&]() {
+        lit.use();
+        lit.setMatrix("projection", projection);
+        loopBatch.draw(lit, view);
+    };
+
+    std::cout << objects << " objects over 4 meshes, " << ctx.frames << " frames, rasterizer discarded" << std::endl;
+    glState().enable(GL_RASTERIZER_DISCARD);
+    auto run = [&](const std::string& label, const std::function<void()>& frame) {
+        timeFrames(std::min(ctx.frames, 10), frame);
+        printFrameStats(label, timeFrames(ctx.frames, frame));
+    };
+    run("VAO per mesh", perMesh);
+    run("batch, base vertex loop", loop);
+    if (indirectBatch.indirect) {
+        Shader indirect("../src/shaders/fullVtxIndirect.glsl", "../src/shaders/lightTypes/combined.glsl");
+        partyLights.attach(indirect);
+        auto multiDraw = [&]() {
+            indirect.use();
+            indirect.setMatrix("view", view);
+            indirect.setMatrix("projection", projection);
+            indirectBatch.draw(indirect, view);
+        };
+        run("batch, multi draw indirect", multiDraw);
+        // every model matrix rewritten, what a fully dynamic scene pays on top
+        run("multi draw, all moved", [&]() {
+            for (unsigned int i = 0; i < objects; i++) indirectBatch.setModel(i, partyModel(i, 0.0f));
+            multiDraw();
+        });
+    } else {
+        std::cout << "no glMultiDrawElementsIndirect on this context, run with --gl 4.3 or later" << std::endl;
+    }
+    glState().disable(GL_RASTERIZER_DISCARD);
+}
+
+// ctx.cubes (at least 2048) meshes of 4 shapes as a VAO each against sub-allocations of one MeshArena, then churn:
+// half released and refilled with other shapes, fragmentation before and after defragment, the image checked unchanged
+void benchMeshArena(BenchContext& ctx) {
+    unsigned int objects = std::max(ctx.cubes, 2048u);
+    MeshData shapes[4];
+    {
+        MeshBuilder cube(true, true);
+        cube.addTriangles(defCubeWithNormTex, sizeof(defCubeWithNormTex) / sizeof(float));
+        shapes[0] = cube.build();
+        const int resolutions[3][2] = { { 6, 12 }, { 10, 20 }, { 16, 32 } };
+        for (int i = 0; i < 3; i++) {
+            std::vector<float> soup = defSphereWithNormTex(resolutions[i][0], resolutions[i][1]);
+            MeshBuilder sphere(true, true);
+            sphere.addTriangles(soup.data(), soup.size());
+            shapes[i + 1] = sphere.build();
+        }
+        for (MeshData& shape : shapes) optimizeMesh(shape);
+    }
+    std::mt19937 rng(42);
+    std::vector<uint32_t> shapeOf(objects);
+    for (uint32_t& shape : shapeOf) shape = rng() % 4;
+
+    std::vector<Mesh> separate(objects);
+    MeshArena arena;
+    std::vector<uint32_t> ids(objects);
+    for (unsigned int i = 0; i < objects; i++) {
+        separate[i] = uploadMesh(shapes[shapeOf[i]]);
+        ids[i] = uploadArenaMesh(arena, shapes[shapeOf[i]]);
+    }
+
+    Shader& lit = ctx.lightingShader;
+    glm::mat4 view = ctx.cam.getViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(ctx.cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f);
+    auto drawAll = [&](const std::function<void(unsigned int)>& drawMesh) {
+        lit.use();
+        lit.setMatrix("view", view);
+        lit.setMatrix("projection", projection);
+        ObjectTransform transform(lit);
+        for (unsigned int i = 0; i < objects; i++) {
+            transform.set(lit, view, partyModel(i, 0.0f));
+            drawMesh(i);
+        }
+    };
+    auto perMesh = [&]() {
+        drawAll([&](unsigned int i) {
+            separate[i].VAO.bind();
+            separate[i].draw();
+        });
+    };
+    auto arenaDraw = [&]() {
+        drawAll([&](unsigned int i) {
+            arena.bind(ids[i]);
+            arena.draw(ids[i]);
+        });
+    };
+
+    std::cout << objects << " meshes of 4 shapes, " << ctx.frames << " frames, rasterizer discarded" << std::endl;
+    glState().enable(GL_RASTERIZER_DISCARD);
+    auto run = [&](const std::string& label, const std::function<void()>& frame) {
+        timeFrames(std::min(ctx.frames, 10), frame);
+        glState().newFrame();
+        FrameStats stats = timeFrames(ctx.frames, frame);
+        glState().newFrame();
+        printFrameStats(label, stats);
+        std::cout << "    " << glState().lastFrame().issued[(int)GLStateCall::VertexArray] / ctx.frames << " VAO binds per frame" << std::endl;
+    };
+    run("VAO per mesh", perMesh);
+    run("mesh arena", arenaDraw);
+    glState().disable(GL_RASTERIZER_DISCARD);
+    printArenaStats("arena after upload", arena.stats());
+
+    // a frame of the arena scene read back, so moving meshes around can be checked against it
+    auto snapshot = [&]() {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        std::vector<unsigned char> pixels((size_t)viewport[2] * viewport[3] * 4);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        arenaDraw();
+        glReadPixels(0, 0, viewport[2], viewport[3], GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        return pixels;
+    };
+    // churn: every other mesh released, then about as many new ones of a different shape, which fit the holes badly
+    for (unsigned int i = 0; i < objects; i += 2) arena.release(ids[i]);
+    for (unsigned int i = 0; i < objects; i += 2) {
+        shapeOf[i] = (shapeOf[i] + 1 + rng() % 3) % 4;
+        ids[i] = uploadArenaMesh(arena, shapes[shapeOf[i]]);
+    }
+    printArenaStats("arena after churn", arena.stats());
+    std::vector<unsigned char> before = snapshot();
+    auto start = std::chrono::steady_clock::now();
+    arena.defragment();
+    glFinish();
+    double defragMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printArenaStats("arena after defragment", arena.stats());
+    std::cout << "defragment took " << defragMs << " ms, image " << (snapshot() == before ? "unchanged" : "CHANGED") << std::endl;
+}
+
+// 1M random spheres and boxes around the camera against its frustum with a 1000 unit far plane, every path the CPU has,
+// single threaded so objects/ms is per core. The visible counts should agree up to objects right on a plane.
+void benchCulling(BenchContext& ctx) {
+    const size_t objects = 1 << 20;
+    SphereSoA spheres;
+    AabbSoA boxes;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f), size(0.1f, 4.0f);
+    for (size_t i = 0; i < objects; i++) {
+        glm::vec3 center(position(rng), position(rng), position(rng));
+        spheres.add(center, size(rng));
+        glm::vec3 extent(size(rng), size(rng), size(rng));
+        boxes.add(center - extent, center + extent);
+    }
+    glm::mat4 projection = glm::perspective(glm::radians(ctx.cam.getFov()), 800.0f / 600.0f, 0.1f, 1000.0f);
+    Frustum frustum = extractFrustum(projection, ctx.cam.getViewMatrix());
+    int frames = std::min(ctx.frames, 100);
+    std::vector<uint32_t> visible;
+
+    std::cout << objects << " objects, " << frames << " frames, best path " << cullPathName(bestCullPath()) << std::endl;
+    for (CullPath path : { CullPath::Scalar, CullPath::SSE, CullPath::AVX2, CullPath::NEON }) {
+        if (!cullPathSupported(path)) continue;
+        size_t sphereCount = 0, boxCount = 0;
+        FrameStats sphereStats = timeFrames(frames, [&]() { sphereCount = cullSpheres(frustum, spheres, visible, path); });
+        FrameStats boxStats = timeFrames(frames, [&]() { boxCount = cullBoxes(frustum, boxes, visible, path); });
+        printFrameStats(std::string(cullPathName(path)) + " spheres", sphereStats);
+        std::cout << "    " << sphereCount << " visible, " << (size_t)(objects / sphereStats.avgMs) << " objects/ms" << std::endl;
+        printFrameStats(std::string(cullPathName(path)) + " boxes", boxStats);
+        std::cout << "    " << boxCount << " visible, " << (size_t)(objects / boxStats.avgMs) << " objects/ms" << std::endl;
+    }
+}
+
+// SAH build of 1M random boxes, then frustum queries against brute force cullBoxes at the camera's 100 unit far plane
+// and a 1000 unit one, crosshair-area rays against a linear scan, and refit after a third of the objects moved
+void benchBvh(BenchContext& ctx) {
+    const size_t objects = 1 << 20;
+    std::vector<Aabb> bounds(objects);
+    AabbSoA soa;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f), size(0.1f, 4.0f);
+    for (Aabb& box : bounds) {
+        glm::vec3 center(position(rng), position(rng), position(rng)), extent(size(rng), size(rng), size(rng));
+        box = { center - extent, center + extent };
+        soa.add(box.min, box.max);
+    }
+    Bvh bvh;
+    auto start = std::chrono::steady_clock::now();
+    bvh.build(bounds);
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << objects << " objects, SAH build " << buildMs << " ms, " << bvh.nodeCount() << " nodes, depth " << bvh.depth() << std::endl;
+
+    int frames = std::min(ctx.frames, 100);
+    glm::mat4 view = ctx.cam.getViewMatrix();
+    std::vector<uint32_t> visible, bruteVisible;
+    for (float farPlane : { 100.0f, 1000.0f }) {
+        Frustum frustum = extractFrustum(glm::perspective(glm::radians(ctx.cam.getFov()), 800.0f / 600.0f, 0.1f, farPlane), view);
+        size_t bvhCount = 0, bruteCount = 0;
+        FrameStats bvhStats = timeFrames(frames, [&]() { bvhCount = bvh.cullFrustum(frustum, visible); });
+        FrameStats bruteStats = timeFrames(frames, [&]() { bruteCount = cullBoxes(frustum, soa, bruteVisible); });
+        std::cout << "far plane " << (int)farPlane << ":" << std::endl;
+        printFrameStats("  bvh frustum", bvhStats);
+        printFrameStats(std::string("  brute force ") + cullPathName(bestCullPath()), bruteStats);
+        std::cout << "    " << bvhCount << " visible through the bvh, " << bruteCount << " brute force" << std::endl;
+    }
+
+    // rays through the central part of the screen, a sample of them checked against every object
+    const int rays = 100000;
+    glm::mat4 projection = glm::perspective(glm::radians(ctx.cam.getFov()), 800.0f / 600.0f, 0.1f, 1000.0f);
+    std::uniform_real_distribution<float> ndc(-0.5f, 0.5f);
+    std::vector<Ray> queries;
+    queries.reserve(rays);
+    for (int i = 0; i < rays; i++) queries.push_back(screenRay(projection, view, ndc(rng), ndc(rng)));
+    int hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (const Ray& ray : queries) {
+        float t;
+        hits += bvh.raycast(ray, t) >= 0;
+    }
+    double rayMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    int mismatches = 0;
+    for (int i = 0; i < 200; i++) {
+        float t, bruteT = FLT_MAX;
+        int picked = bvh.raycast(queries[i], t), brute = -1;
+        for (size_t j = 0; j < objects; j++) {
+            float enter = intersectAabb(queries[i], bounds[j].min, bounds[j].max, bruteT);
+            if (enter < bruteT) {
+                bruteT = enter;
+                brute = (int)j;
+            }
+        }
+        mismatches += picked != brute && !(picked >= 0 && brute >= 0 && t == bruteT);
+    }
+    std::cout << rays << " rays in " << rayMs << " ms, " << (size_t)(rays / rayMs) << " rays/ms, " << hits << " hits, "
+              << mismatches << "/200 differ from a linear scan" << std::endl;
+
+    // objects moving a little, like the rotating party cubes, every 1000th and every third
+    for (size_t stride : { 1000, 3 }) {
+        std::vector<Aabb> moved;
+        for (size_t i = 0; i < objects; i += stride) {
+            glm::vec3 offset(ndc(rng), ndc(rng), ndc(rng));
+            moved.push_back({ bounds[i].min + offset, bounds[i].max + offset });
+        }
+        FrameStats refitStats = timeFrames(frames, [&]() {
+            for (size_t i = 0, j = 0; i < objects; i += stride, j++) bvh.update((uint32_t)i, moved[j]);
+            bvh.refit();
+        });
+        printFrameStats("update + refit 1/" + std::to_string(stride), refitStats);
+    }
+    printFrameStats("refit every node", timeFrames(frames, [&]() { bvh.refitAll(); }));
+    bvh.cullFrustum(extractFrustum(projection, view), visible);
+    std::cout << "    " << visible.size() << " visible after refit" << std::endl;
+}
+
+// buildPartyDraws over 1M party cubes (or --cubes when larger) on 1, 2, 4 ... threads up to one per core,
+// the draws must come out the same on every thread count
+void benchJobs(BenchContext& ctx) {
+    unsigned int count = std::max(ctx.cubes, 1u << 20);
+    SphereSoA bounds = partyBounds(count);
+    glm::mat4 view = ctx.cam.getViewMatrix();
+    Frustum frustum = extractFrustum(glm::perspective(glm::radians(ctx.cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f), view);
+    int frames = std::min(ctx.frames, 100);
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int threads = 1; threads < cores; threads *= 2) threadCounts.push_back(threads);
+    threadCounts.push_back(cores);
+
+    std::cout << count << " cubes, " << frames << " frames, " << cores << " core(s)" << std::endl;
+    double singleMs = 0.0;
+    PartyFrame reference;
+    for (unsigned int threads : threadCounts) {
+        JobSystem jobs(threads);
+        PartyFrame frame;
+        FrameStats stats = timeFrames(frames, [&]() { buildPartyDraws(jobs, frustum, bounds, view, 1.0f, frame); });
+        JobStats jobStats = jobs.stats();
+        if (threads == 1) {
+            singleMs = stats.avgMs;
+            reference = frame;
+        }
+        size_t drawn = 0;
+        bool same = frame.counts == reference.counts;
+        for (size_t c = 0; c < frame.counts.size(); c++) {
+            drawn += frame.counts[c];
+            for (uint32_t i = 0; same && i < frame.counts[c]; i++)
+                same = frame.draws[c * PARTY_CHUNK + i].modelView == reference.draws[c * PARTY_CHUNK + i].modelView;
+        }
+        printFrameStats(std::to_string(threads) + " thread(s)", stats);
+        std::cout << "    " << singleMs / stats.avgMs << "x, " << drawn << " draws" << (same ? "" : " DIFFER from 1 thread") << ", "
+                  << jobStats.jobs << " jobs, " << jobStats.steals << " stolen" << std::endl;
+    }
+}
+
+// RGB PNG of smooth gradients plus noise, rows Sub filtered and deflate stored uncompressed since there is no encoder
+// around, so decoding costs a copy and the unfilter where real files would also inflate
+void writeTestPng(const char* path, int width, int height, unsigned int seed) {
+    static uint32_t crcTable[256];
+    if (!crcTable[1])
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crcTable[n] = c;
+        }
+    auto put32 = [](std::vector<unsigned char>& out, uint32_t v) {
+        for (int shift = 24; shift >= 0; shift -= 8) out.push_back((unsigned char)(v >> shift));
+    };
+    auto chunk = [&](FILE* file, const char* type, const std::vector<unsigned char>& data) {
+        std::vector<unsigned char> out;
+        put32(out, (uint32_t)data.size());
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        uint32_t crc = ~0u;
+        for (size_t i = 4; i < out.size(); i++) crc = crcTable[(crc ^ out[i]) & 0xff] ^ (crc >> 8);
+        put32(out, ~crc);
+        fwrite(out.data(), 1, out.size(), file);
+    };
+    FILE* file = fopen(path, "wb");
+    if (!file) return;
+    const unsigned char signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    fwrite(signature, 1, sizeof(signature), file);
+    std::vector<unsigned char> header;
+    put32(header, width);
+    put32(header, height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 }); // 8 bit RGB
+    chunk(file, "IHDR", header);
+
+    size_t rowBytes = (size_t)width * 3 + 1;
+    std::vector<unsigned char> raw(rowBytes * height);
+    std::mt19937 rng(seed);
+    for (int y = 0; y < height; y++) {
+        unsigned char* row = &raw[y * rowBytes];
+        row[0] = 1; // Sub
+        unsigned char previous[3] = {};
+        for (int x = 0; x < width; x++)
+            for (int c = 0; c < 3; c++) {
+                unsigned char value = (unsigned char)((x * (c + 1) + y * (3 - c)) / 16 + (rng() & 15));
+                row[1 + x * 3 + c] = (unsigned char)(value - previous[c]);
+                previous[c] = value;
+            }
+    }
+    std::vector<unsigned char> zlib = { 0x78, 0x01 };
+    uint32_t a = 1, b = 0;
+    for (unsigned char byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    for (size_t offset = 0; offset < raw.size(); offset += 65535) {
+        size_t n = std::min<size_t>(65535, raw.size() - offset);
+        zlib.push_back(offset + n == raw.size());
+        zlib.insert(zlib.end(), { (unsigned char)n, (unsigned char)(n >> 8), (unsigned char)~n, (unsigned char)(~n >> 8) });
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + n);
+    }
+    put32(zlib, b << 16 | a);
+    chunk(file, "IDAT", zlib);
+    chunk(file, "IEND", {});
+    fclose(file);
+}
+
+// 24 generated 2048x2048 textures (12 MB of level 0 each) loaded before the first frame with loadTexture, against
+// streaming them through a TextureLoader at a few budgets while the party keeps drawing. Every frame ends in glFinish.
+void benchTextureStreaming(BenchContext& ctx) {
+    const int count = 24, size = 2048;
+    std::vector<std::string> paths;
+    for (int i = 0; i < count; i++) {
+        paths.push_back("bench_texture_" + std::to_string(i) + ".png");
+        FILE* existing = fopen(paths.back().c_str(), "rb");
+        if (existing) fclose(existing);
+        else {
+            if (i == 0) std::cout << "writing " << count << " test textures..." << std::endl;
+            writeTestPng(paths.back().c_str(), size, size, i);
+        }
+    }
+    auto now = []() { return std::chrono::steady_clock::now(); };
+    auto ms = [](std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+    auto frame = [&]() {
+        drawPartyCL(ctx.cam, ctx.cube, ctx.lightingShader, ctx.cubes);
+        glFinish();
+    };
+    FrameStats idle = timeFrames(std::min(ctx.frames, 50), frame, true);
+    printFrameStats("no loading", idle);
+
+    {
+        std::vector<Texture> textures(count);
+        auto start = now();
+        for (int i = 0; i < count; i++) textures[i] = loadTexture(paths[i].c_str());
+        frame();
+        std::cout << "loadTexture up front: first frame after " << ms(start, now()) << " ms" << std::endl;
+    }
+    for (size_t budget : { (size_t)2 << 20, (size_t)8 << 20, (size_t)32 << 20 }) {
+        std::vector<Texture> textures(count);
+        double worst = 0.0, firstFrame = 0.0, total = 0.0;
+        int frames = 0;
+        auto start = now();
+        {
+            TextureLoader loader(0, budget);
+            for (int i = 0; i < count; i++) loader.request(paths[i].c_str(), textures[i]);
+            while (!loader.idle()) {
+                auto frameStart = now();
+                loader.update();
+                frame();
+                worst = std::max(worst, ms(frameStart, now()));
+                if (frames++ == 0) firstFrame = ms(start, now());
+            }
+            total = ms(start, now());
+        }
+        std::cout << "streamed, " << (budget >> 20) << " MB/frame: first frame after " << firstFrame << " ms, worst frame "
+                  << worst << " ms, all resident after " << frames << " frames, " << total << " ms" << std::endl;
+    }
+}
+
+// the party maps reloaded the way a sample switch does, cold and through the cache, then LRU eviction cycling through
+// the bundled images under an 8 MB budget and eight streamed requests for one file before the loader runs
+void benchTextureCache(BenchContext&) {
+    TextureCache& cache = textureCache();
+    auto ms = [](std::chrono::steady_clock::time_point from) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+    };
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; i++) {
+        Texture fresh = loadTexture(i == 0 ? "../public/container2.png" : i == 1 ? "../public/lighting_maps_specular_color.png" : "../public/matrix.jpg");
+    }
+    glFinish();
+    std::cout << "party maps through loadTexture: " << ms(start) << " ms" << std::endl;
+    start = std::chrono::steady_clock::now();
+    loadPartyMaps();
+    glFinish();
+    std::cout << "party maps through the cache: " << ms(start) << " ms" << std::endl;
+    cache.print();
+
+    const char* files[] = { "../public/container.jpg", "../public/awesomeface.png", "../public/container2.png",
+                            "../public/lighting_maps_specular_color.png", "../public/matrix.jpg" };
+    size_t savedBudget = cache.budget;
+    cache.budget = 8 << 20;
+    TextureOptions kaiser; // keyed apart from the party maps loaded above
+    kaiser.mipFilter = MipFilter::Kaiser;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; i++) {
+        // mostly the first two, now and then one of the rest, every handle let go right away
+        TextureHandle handle = cache.acquire(files[i % 4 ? i % 2 : 2 + i / 4 % 3], kaiser);
+    }
+    glFinish();
+    std::cout << "100 acquires over 5 files: " << ms(start) << " ms" << std::endl;
+    cache.print();
+    cache.budget = savedBudget;
+    cache.clear();
+
+    TextureLoader loader;
+    cache.loader = &loader;
+    TextureOptions srgb;
+    srgb.srgb = true;
+    std::vector<TextureHandle> handles;
+    for (int i = 0; i < 8; i++) handles.push_back(cache.acquire("../public/awesomeface.png", srgb));
+    while (!loader.idle()) loader.update();
+    cache.loader = nullptr;
+    std::cout << "8 requests while streaming: " << loader.stats().requested << " decode(s), " << loader.stats().resident
+              << " upload(s), every handle " << (handles.back().get() == handles.front().get() ? "shares one texture" : "DIFFERS") << std::endl;
+    cache.print();
+
+    // a file that is not there fails, the next acquire tries it again, and neither entry outlives its handles
+    cache.loader = &loader;
+    size_t before = cache.size();
+    TextureHandle missing = cache.acquire("../public/missing.png");
+    while (!loader.idle()) loader.update();
+    TextureHandle retry = cache.acquire("../public/missing.png");
+    while (!loader.idle()) loader.update();
+    cache.loader = nullptr;
+    bool retried = missing.get() != retry.get();
+    missing = retry = TextureHandle();
+    size_t failed = cache.size() - before;
+    cache.clear();
+    std::cout << "missing file: " << cache.stats().failures << " failed load(s), " << (retried ? "retried" : "NOT retried") << ", "
+              << failed << " entries while held, " << cache.size() << " textures left after clear against " << before << " before" << std::endl;
+    cache.print();
+}
+
+// encode throughput and quality of every format on one image, scalar against SIMD and one thread against all,
+// then what a cooked file saves on load and in VRAM, natively and through the CPU decode fallback
+void benchBlockCompression(BenchContext&) {
+    int width, height, components;
+    unsigned char* rgba = stbi_load("../public/container2.png", &width, &height, &components, 4);
+    if (!rgba) return;
+    size_t texels = (size_t)width * height;
+    JobSystem single(1), pool;
+    std::vector<uint8_t> blocks, decoded(texels * 4);
+    bool simd = bcnSimd;
+    static const BcnFormat formats[] = { BcnFormat::BC1, BcnFormat::BC3, BcnFormat::BC4, BcnFormat::BC5, BcnFormat::BC7 };
+    for (BcnFormat format : formats) {
+        blocks.resize(bcnLevelBytes(format, width, height));
+        std::cout << bcnFormatName(format) << " " << width << "x" << height << ":";
+        const char* runs[] = { "scalar", "simd", "simd" };
+        for (int run = 0; run < 3; run++) {
+            bcnSimd = run > 0 && simd;
+            JobSystem& jobs = run < 2 ? single : pool;
+            FrameStats stats = timeFrames(3, [&]() { bcnEncodeLevel(jobs, format, rgba, width, height, blocks.data()); });
+            std::cout << " " << runs[run] << " x" << jobs.threadCount() << " " << std::fixed << std::setprecision(1) << texels / stats.minMs / 1000.0 << " MPix/s,";
+        }
+        bcnDecodeLevel(format, blocks.data(), width, height, decoded.data());
+        std::cout << " PSNR " << bcnPsnr(format, rgba, decoded.data(), texels) << " dB" << std::endl;
+    }
+    bcnSimd = simd;
+
+    BcnImage image = cookTexture(pool, BcnFormat::BC1, false, rgba, width, height);
+    stbi_image_free(rgba);
+    const char* cookedPath = "bench_container2.dds";
+    if (!writeDdsFile(cookedPath, image)) return;
+    const char* labels[] = { "png + CPU mip chain", "cooked BC1", "cooked BC1, CPU decoded" };
+    for (int run = 0; run < 3; run++) {
+        forceTextureDecompression = run == 2;
+        size_t bytes = 0;
+        FrameStats stats = timeFrames(5, [&]() {
+            Texture texture = loadTexture(run == 0 ? "../public/container2.png" : cookedPath);
+            bytes = glResources().bytes(GLResourceType::Texture, texture.id());
+        }, true);
+        std::cout << std::left << std::setw(26) << labels[run] << std::right << " load " << stats.minMs << " ms, " << bytes / 1024 << " KB of VRAM" << std::endl;
+    }
+    forceTextureDecompression = false;
+}
+
+// CPU mip chains of a 2048x2048 RGBA image, every kernel path against the scalar reference on one thread and on all,
+// then what the sRGB path changes and what uploading a CPU chain costs next to glGenerateMipmap
+void benchMipmaps(BenchContext&) {
+    const int size = 2048;
+    std::vector<unsigned char> image((size_t)size * size * 4);
+    std::mt19937 rng(7);
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++)
+            for (int c = 0; c < 4; c++) image[((size_t)y * size + x) * 4 + c] = (unsigned char)(((x >> 3) ^ (y >> 3)) * (c + 1) + rng() % 32);
+    std::vector<unsigned char> reference(mipChainBytes(size, size, 4)), chain(reference.size());
+    JobSystem single(1), pool;
+    struct Case {
+        const char* name;
+        MipFilter filter;
+        bool srgb, normalMap;
+    };
+    const Case cases[] = { { "box", MipFilter::Box, false, false }, { "box sRGB", MipFilter::Box, true, false },
+                           { "kaiser", MipFilter::Kaiser, false, false }, { "kaiser normal", MipFilter::Kaiser, false, true } };
+    for (const Case& test : cases) {
+        MipOptions options;
+        options.filter = test.filter;
+        options.srgb = test.srgb;
+        options.normalMap = test.normalMap;
+        generateMipChain(nullptr, image.data(), size, size, 4, reference.data(), options, MipPath::Scalar);
+        std::cout << std::left << std::setw(14) << test.name << std::right;
+        for (MipPath path : { MipPath::Scalar, MipPath::SSE, MipPath::AVX2 }) {
+            if (!mipPathSupported(path)) continue;
+            for (JobSystem* jobs : { &single, &pool }) {
+                if (jobs == &pool && pool.threadCount() == 1) continue;
+                FrameStats stats = timeFrames(3, [&]() { generateMipChain(jobs, image.data(), size, size, 4, chain.data(), options, path); });
+                std::cout << " " << mipPathName(path) << " x" << jobs->threadCount() << " " << std::fixed << std::setprecision(1)
+                          << (double)size * size / stats.minMs / 1000.0 << " MPix/s" << (chain == reference ? "," : " (DIFFERS),");
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    // a black and white checker averages to 50% in linear light, which is 188 in sRGB rather than 128
+    std::vector<unsigned char> checker(64 * 64 * 4), small(mipChainBytes(64, 64, 4));
+    for (int i = 0; i < 64 * 64; i++)
+        for (int c = 0; c < 4; c++) checker[i * 4 + c] = c == 3 || (i % 64 + i / 64) % 2 ? 255 : 0;
+    MipOptions srgb;
+    srgb.srgb = true;
+    generateMipChain(nullptr, checker.data(), 64, 64, 4, small.data());
+    std::cout << "checker 1x1 level: " << (int)small[small.size() - 4];
+    generateMipChain(nullptr, checker.data(), 64, 64, 4, small.data(), srgb);
+    std::cout << " gamma unaware, " << (int)small[small.size() - 4] << " filtered in linear" << std::endl;
+
+    Texture texture;
+    texture.generate();
+    texture.bind();
+    FrameStats gpu = timeFrames(5, [&]() {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }, true);
+    FrameStats cpu = timeFrames(5, [&]() {
+        generateMipChain(&pool, image.data(), size, size, 4, chain.data());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+        const unsigned char* level = chain.data();
+        for (int i = 1, w = size, count = mipLevelCount(size, size); i < count; i++) {
+            w = std::max(1, w / 2);
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, w, w, 0, GL_RGBA, GL_UNSIGNED_BYTE, level);
+            level += (size_t)w * w * 4;
+        }
+    }, true);
+    printFrameStats("upload + glGenerateMipmap", gpu);
+    printFrameStats("CPU chain + upload", cpu);
+}
+
+// 64 textures of 256x256 with a full chain made through mutable glTexImage2D levels plus per texture parameters and
+// through glTexStorage2D, each drawn once so the driver's completeness checks land in the timing, then the party cubes
+// flipping every other cube between two sampling modes by rewriting texture parameters against binding samplers
+void benchSamplers(BenchContext& ctx) {
+    const int size = 256, count = 64;
+    int levels = mipLevelCount(size, size);
+    std::vector<unsigned char> image((size_t)size * size * 4, 128), chain(mipChainBytes(size, size, 4));
+    generateMipChain(nullptr, image.data(), size, size, 4, chain.data());
+    std::cout << "glTexStorage2D " << (textureStorageSupported() ? "available" : "missing, allocated level by level") << std::endl;
+
+    auto drawEach = [&](std::vector<Texture>& textures) {
+        ctx.lightingShader.use();
+        ctx.cube.VAO.bind();
+        for (Texture& texture : textures) {
+            texture.bind(0, GL_TEXTURE_2D);
+            ctx.cube.draw();
+        }
+    };
+    auto upload = [&](bool subImage) {
+        const unsigned char* level = image.data();
+        for (int i = 0, w = size; i < levels; i++, w = std::max(1, w / 2)) {
+            if (subImage) glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, w, w, GL_RGBA, GL_UNSIGNED_BYTE, level);
+            else glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, w, w, 0, GL_RGBA, GL_UNSIGNED_BYTE, level);
+            level = i == 0 ? chain.data() : level + (size_t)w * w * 4;
+        }
+    };
+    glState().bindSampler(0, 0);
+    std::vector<Texture> textures(count);
+    FrameStats mutableStats = timeFrames(5, [&]() {
+        for (Texture& texture : textures) {
+            texture.generate();
+            texture.bind(0, GL_TEXTURE_2D);
+            upload(false);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+        drawEach(textures);
+    }, true);
+    const Sampler& trilinear = samplerCache().get(SamplerDesc());
+    trilinear.bind(0);
+    FrameStats immutableStats = timeFrames(5, [&]() {
+        for (Texture& texture : textures) {
+            texture.generate();
+            texture.bind(0, GL_TEXTURE_2D);
+            allocateTextureStorage(GL_RGBA8, levels, size, size);
+            upload(true);
+        }
+        drawEach(textures);
+    }, true);
+    printFrameStats("glTexImage2D + parameters", mutableStats);
+    printFrameStats("glTexStorage2D + sampler", immutableStats);
+
+    // one image read two ways, the old way needs parameter writes on the texture itself
+    const Sampler& nearest = samplerCache().get(SamplerDesc(GL_CLAMP_TO_EDGE, GL_NEAREST_MIPMAP_NEAREST, GL_NEAREST));
+    const Sampler* modes[] = { partySampler, &nearest };
+    auto party = [&](bool samplers) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        ctx.lightingShader.use();
+        ctx.cube.VAO.bind();
+        glm::mat4 view = ctx.cam.getViewMatrix();
+        ctx.lightingShader.setMatrix("view", view);
+        ctx.lightingShader.setMatrix("projection", glm::perspective(glm::radians(ctx.cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f));
+        ObjectTransform transform(ctx.lightingShader);
+        float time = (float)glfwGetTime();
+        for (unsigned int i = 0; i < ctx.cubes; i++) {
+            for (int unit = 0; unit < 3; unit++) {
+                partyMaps[unit].bind(unit, GL_TEXTURE_2D);
+                if (samplers) modes[i % 2]->bind(unit);
+                else {
+                    glState().activeTexture(GL_TEXTURE0 + unit);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, i % 2 ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, i % 2 ? GL_NEAREST : GL_LINEAR);
+                }
+            }
+            transform.set(ctx.lightingShader, view, partyModel(i, time));
+            ctx.cube.draw();
+        }
+    };
+    for (int unit = 0; unit < 3; unit++) glState().bindSampler(unit, 0);
+    FrameStats parameterStats = timeFrames(ctx.frames, [&]() { party(false); }, true);
+    FrameStats samplerStats = timeFrames(ctx.frames, [&]() { party(true); }, true);
+    std::cout << "party, " << ctx.cubes << " cubes alternating two sampling modes" << std::endl;
+    printFrameStats("texture parameters", parameterStats);
+    printFrameStats("sampler objects", samplerStats);
+    // the parameter writes stick to the party maps, put them back the way loadTexture leaves them
+    for (int unit = 0; unit < 3; unit++) {
+        glState().activeTexture(GL_TEXTURE0 + unit);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    bindPartyMaps();
+    std::cout << samplerCache().size() << " sampler objects in the cache" << std::endl;
+}
+
+// returns false when no benchmark goes by that name
+bool runBench(const std::string& name, BenchContext& ctx) {
+    if (name == "uniforms") benchUniformCache(ctx);
+    else if (name == "instancing") benchInstancing(ctx);
+    else if (name == "normals") benchNormalMatrix(ctx);
+    else if (name == "meshes") benchMeshes(ctx);
+    else if (name == "vertexcache") benchVertexCache(ctx);
+    else if (name == "obj") benchObjLoader(ctx);
+    else if (name == "cooked") benchCookedMesh(ctx);
+    else if (name == "quantize") benchQuantize(ctx);
+    else if (name == "state") benchStateCache(ctx);
+    else if (name == "queue") benchRenderQueue(ctx);
+    else if (name == "indirect") benchIndirect(ctx);
+    else if (name == "arena") benchMeshArena(ctx);
+    else if (name == "cull") benchCulling(ctx);
+    else if (name == "bvh") benchBvh(ctx);
+    else if (name == "jobs") benchJobs(ctx);
+    else if (name == "textures") benchTextureStreaming(ctx);
+    else if (name == "texturecache") benchTextureCache(ctx);
+    else if (name == "bcn") benchBlockCompression(ctx);
+    else if (name == "mips") benchMipmaps(ctx);
+    else if (name == "samplers") benchSamplers(ctx);
+    else {
+        std::cerr << "Unknown benchmark: " << name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#endif
\ No newline at end of file
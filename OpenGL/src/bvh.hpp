@@ -0,0 +1,352 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+#include "culling.hpp"
+
+struct Aabb {
+    glm::vec3 min = glm::vec3(FLT_MAX), max = glm::vec3(-FLT_MAX);
+
+    void grow(const glm::vec3& p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+    void grow(const Aabb& b) {
+        min = glm::min(min, b.min);
+        max = glm::max(max, b.max);
+    }
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    float area() const {
+        glm::vec3 e = max - min;
+        return e.x < 0.0f ? 0.0f : 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+};
+
+// bounds of an object space box after model, the box stays axis aligned by taking the absolute rotation
+Aabb transformAabb(const Aabb& box, const glm::mat4& model) {
+    glm::vec3 c = glm::vec3(model * glm::vec4(box.center(), 1.0f)), e = (box.max - box.min) * 0.5f;
+    glm::mat3 m(model);
+    glm::vec3 extent = glm::abs(m[0]) * e.x + glm::abs(m[1]) * e.y + glm::abs(m[2]) * e.z;
+    return { c - extent, c + extent };
+}
+
+struct Ray {
+    glm::vec3 origin, dir, invDir;
+
+    Ray(const glm::vec3& origin, const glm::vec3& dir) : origin(origin), dir(glm::normalize(dir)) { invDir = 1.0f / this->dir; }
+};
+
+// ray through a point of the viewport in NDC starting on the near plane, (0, 0) is the crosshair of the FPS camera
+Ray screenRay(const glm::mat4& projection, const glm::mat4& view, float ndcX, float ndcY) {
+    glm::mat4 inv = glm::inverse(projection * view);
+    glm::vec4 near = inv * glm::vec4(ndcX, ndcY, -1.0f, 1.0f), far = inv * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    glm::vec3 from = glm::vec3(near) / near.w, to = glm::vec3(far) / far.w;
+    return Ray(from, to - from);
+}
+
+// entry distance of the slab test, FLT_MAX on a miss or when the box starts beyond maxT
+float intersectAabb(const Ray& ray, const glm::vec3& min, const glm::vec3& max, float maxT) {
+    glm::vec3 t0 = (min - ray.origin) * ray.invDir, t1 = (max - ray.origin) * ray.invDir;
+    glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxT));
+    return enter <= exit ? enter : FLT_MAX;
+}
+
+// 32 byte node: a leaf has count objects from first in the object order, an inner node has count 0 and
+// its two children next to each other at first and first + 1
+struct BvhNode {
+    glm::vec3 min;
+    uint32_t first;
+    glm::vec3 max;
+    uint32_t count;
+
+    bool leaf() const { return count > 0; }
+};
+
+// SAH built hierarchy over object bounds, flattened into one node array with children always after their parent,
+// so a reverse sweep visits children first. Object bounds are stored in leaf order next to their ids, a leaf's objects
+// are one contiguous run. Object ids are the indices of the bounds passed to build.
+class Bvh {
+private:
+    static const int BINS = 16;
+    static const uint32_t MAX_LEAF = 8; // larger leaves are always split, smaller ones only when SAH says so
+    static const int MAX_DEPTH = 60; // bounds the fixed traversal stacks, only degenerate input gets near it
+    static constexpr float TRAVERSAL_COST = 1.0f; // one more node test, in units of an object bounds test
+
+    struct BuildPrim {
+        Aabb box;
+        glm::vec3 center;
+        uint32_t id;
+    };
+
+    std::vector<BvhNode> nodes;
+    std::vector<Aabb> bounds; // leaf order
+    std::vector<uint32_t> order; // object id of every bounds entry
+    std::vector<uint32_t> slotOf, leafOf, parents; // per object: index into bounds and its leaf, per node: parent
+    std::vector<uint32_t> dirty;
+    std::vector<uint8_t> dirtyFlag;
+    bool refitEverything = false;
+
+    template <typename Box>
+    void fitNode(uint32_t index, Box objectBox) {
+        BvhNode& node = nodes[index];
+        Aabb box;
+        if (node.leaf()) {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) box.grow(objectBox(i));
+        } else {
+            box.grow(Aabb{ nodes[node.first].min, nodes[node.first].max });
+            box.grow(Aabb{ nodes[node.first + 1].min, nodes[node.first + 1].max });
+        }
+        node.min = box.min;
+        node.max = box.max;
+    }
+
+    void fitNode(uint32_t index) {
+        fitNode(index, [&](uint32_t i) -> const Aabb& { return bounds[i]; });
+    }
+
+    // binned SAH over centroids, false when keeping the leaf is cheaper than any split
+    bool split(uint32_t index, std::vector<BuildPrim>& prims, uint32_t& mid) {
+        const BvhNode& node = nodes[index];
+        Aabb centroidBox;
+        for (uint32_t i = node.first; i < node.first + node.count; i++) centroidBox.grow(prims[i].center);
+        float bestCost = FLT_MAX;
+        int bestAxis = -1, bestBin = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            float lo = centroidBox.min[axis], hi = centroidBox.max[axis];
+            if (hi <= lo) continue;
+            Aabb binBox[BINS];
+            uint32_t binCount[BINS] = {};
+            float scale = BINS / (hi - lo);
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                int bin = std::min(BINS - 1, (int)((prims[i].center[axis] - lo) * scale));
+                binBox[bin].grow(prims[i].box);
+                binCount[bin]++;
+            }
+            // right to left sweep first, then each plane between bin b and b + 1 costs left area * count + right area * count
+            float rightArea[BINS - 1];
+            uint32_t rightCount[BINS - 1];
+            Aabb right;
+            uint32_t count = 0;
+            for (int b = BINS - 1; b > 0; b--) {
+                right.grow(binBox[b]);
+                count += binCount[b];
+                rightArea[b - 1] = right.area();
+                rightCount[b - 1] = count;
+            }
+            Aabb left;
+            count = 0;
+            for (int b = 0; b < BINS - 1; b++) {
+                left.grow(binBox[b]);
+                count += binCount[b];
+                if (!count || !rightCount[b]) continue;
+                float cost = count * left.area() + rightCount[b] * rightArea[b];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+        float area = Aabb{ node.min, node.max }.area();
+        if (bestAxis < 0 || (TRAVERSAL_COST * area + bestCost >= node.count * area && node.count <= MAX_LEAF)) return false;
+
+        float lo = centroidBox.min[bestAxis], scale = BINS / (centroidBox.max[bestAxis] - lo);
+        auto inLeft = [&](const BuildPrim& p) { return std::min(BINS - 1, (int)((p.center[bestAxis] - lo) * scale)) <= bestBin; };
+        mid = (uint32_t)(std::partition(prims.begin() + node.first, prims.begin() + node.first + node.count, inLeft) - prims.begin());
+        return true;
+    }
+public:
+    void build(const std::vector<Aabb>& objectBounds) {
+        uint32_t n = (uint32_t)objectBounds.size();
+        std::vector<BuildPrim> prims(n);
+        for (uint32_t i = 0; i < n; i++) prims[i] = { objectBounds[i], objectBounds[i].center(), i };
+        auto primBox = [&](uint32_t i) -> const Aabb& { return prims[i].box; };
+        nodes.clear();
+        parents.clear();
+        dirty.clear();
+        refitEverything = false;
+        nodes.reserve(2 * (size_t)n);
+        parents.reserve(2 * (size_t)n);
+        bounds.resize(n);
+        order.resize(n);
+        slotOf.resize(n);
+        leafOf.resize(n);
+        dirtyFlag.clear();
+        if (!n) return;
+        nodes.push_back({ glm::vec3(0.0f), 0, glm::vec3(0.0f), n });
+        parents.push_back(~0u);
+        fitNode(0, primBox);
+        std::vector<std::pair<uint32_t, int>> stack = { { 0, 1 } };
+        while (!stack.empty()) {
+            uint32_t index = stack.back().first;
+            int depth = stack.back().second;
+            stack.pop_back();
+            uint32_t mid;
+            if (depth >= MAX_DEPTH || !split(index, prims, mid)) continue;
+            if (mid == nodes[index].first || mid == nodes[index].first + nodes[index].count) continue;
+            uint32_t first = nodes[index].first, count = nodes[index].count, left = (uint32_t)nodes.size();
+            nodes.push_back({ glm::vec3(0.0f), first, glm::vec3(0.0f), mid - first });
+            nodes.push_back({ glm::vec3(0.0f), mid, glm::vec3(0.0f), first + count - mid });
+            parents.push_back(index);
+            parents.push_back(index);
+            nodes[index].first = left;
+            nodes[index].count = 0;
+            fitNode(left, primBox);
+            fitNode(left + 1, primBox);
+            stack.push_back({ left + 1, depth + 1 });
+            stack.push_back({ left, depth + 1 });
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            bounds[i] = prims[i].box;
+            order[i] = prims[i].id;
+            slotOf[order[i]] = i;
+        }
+        for (uint32_t i = 0; i < nodes.size(); i++) {
+            if (!nodes[i].leaf()) continue;
+            for (uint32_t j = nodes[i].first; j < nodes[i].first + nodes[i].count; j++) leafOf[order[j]] = i;
+        }
+        dirtyFlag.assign(nodes.size(), 0);
+    }
+
+    // new bounds for a moving object, the tree keeps its shape and refit only grows or shrinks the boxes on its path
+    void update(uint32_t object, const Aabb& box) {
+        bounds[slotOf[object]] = box;
+        if (refitEverything) return;
+        if (dirty.size() > nodes.size() / 8) refitEverything = true;
+        for (uint32_t index = leafOf[object]; index != ~0u && !dirtyFlag[index]; index = parents[index]) {
+            dirtyFlag[index] = 1;
+            dirty.push_back(index);
+        }
+    }
+
+    // refits the nodes update touched, children first since they always sit after their parent.
+    // Past an eighth of the tree tracking costs more than it saves and every node is refit instead.
+    void refit() {
+        if (refitEverything) {
+            for (uint32_t index : dirty) dirtyFlag[index] = 0;
+            dirty.clear();
+            refitEverything = false;
+            refitAll();
+            return;
+        }
+        std::sort(dirty.begin(), dirty.end(), [](uint32_t a, uint32_t b) { return a > b; });
+        for (uint32_t index : dirty) {
+            fitNode(index);
+            dirtyFlag[index] = 0;
+        }
+        dirty.clear();
+    }
+
+    // every node, what a refit without update tracking costs
+    void refitAll() {
+        for (size_t i = nodes.size(); i-- > 0;) fitNode((uint32_t)i);
+    }
+
+    // ids of the objects whose bounds intersect the frustum, the same set cullBoxes gives. Planes a node is fully inside
+    // are dropped for its subtree, a node inside all six takes its objects without testing them.
+    size_t cullFrustum(const Frustum& f, std::vector<uint32_t>& visible) const {
+        visible.clear();
+        if (nodes.empty()) return 0;
+        glm::vec3 absNormals[6];
+        for (int p = 0; p < 6; p++) absNormals[p] = glm::abs(glm::vec3(f.planes[p]));
+        auto classify = [&](const glm::vec3& min, const glm::vec3& max, uint32_t& planes) {
+            glm::vec3 c = (min + max) * 0.5f, e = (max - min) * 0.5f;
+            for (int p = 0; p < 6; p++) {
+                if (!(planes & (1u << p))) continue;
+                float dist = glm::dot(glm::vec3(f.planes[p]), c) + f.planes[p].w, radius = glm::dot(absNormals[p], e);
+                if (dist + radius < 0.0f) return false;
+                if (dist - radius >= 0.0f) planes &= ~(1u << p);
+            }
+            return true;
+        };
+        struct Entry {
+            uint32_t node, planes;
+        };
+        Entry stack[MAX_DEPTH + 1];
+        int top = 0;
+        stack[top++] = { 0, 0x3f };
+        while (top > 0) {
+            Entry entry = stack[--top];
+            const BvhNode& node = nodes[entry.node];
+            uint32_t planes = entry.planes;
+            if (!classify(node.min, node.max, planes)) continue;
+            if (!node.leaf()) {
+                stack[top++] = { node.first + 1, planes };
+                stack[top++] = { node.first, planes };
+                continue;
+            }
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                uint32_t objectPlanes = planes;
+                if (!planes || classify(bounds[i].min, bounds[i].max, objectPlanes)) visible.push_back(order[i]);
+            }
+        }
+        return visible.size();
+    }
+
+    // nearest object whose bounds the ray enters within maxT, -1 for none. hit(object, t) may refine t with an exact test
+    // and returns FLT_MAX to let the ray pass, by default the object bounds are the hit.
+    template <typename Hit>
+    int raycast(const Ray& ray, float& t, Hit hit, float maxT = FLT_MAX) const {
+        int best = -1;
+        t = maxT;
+        if (nodes.empty()) return best;
+        uint32_t stack[MAX_DEPTH + 1];
+        int top = 0;
+        if (intersectAabb(ray, nodes[0].min, nodes[0].max, t) == FLT_MAX) return best;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BvhNode& node = nodes[stack[--top]];
+            if (node.leaf()) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    float enter = intersectAabb(ray, bounds[i].min, bounds[i].max, t);
+                    if (enter == FLT_MAX) continue;
+                    float exact = hit(order[i], enter);
+                    if (exact < t) {
+                        t = exact;
+                        best = (int)order[i];
+                    }
+                }
+                continue;
+            }
+            // nearer child last so it is popped first and shortens t for the other one
+            float tl = intersectAabb(ray, nodes[node.first].min, nodes[node.first].max, t);
+            float tr = intersectAabb(ray, nodes[node.first + 1].min, nodes[node.first + 1].max, t);
+            uint32_t nearChild = tl <= tr ? node.first : node.first + 1, farChild = tl <= tr ? node.first + 1 : node.first;
+            if (std::max(tl, tr) != FLT_MAX) stack[top++] = farChild;
+            if (std::min(tl, tr) != FLT_MAX) stack[top++] = nearChild;
+        }
+        return best;
+    }
+
+    int raycast(const Ray& ray, float& t, float maxT = FLT_MAX) const {
+        return raycast(ray, t, [](uint32_t, float enter) { return enter; }, maxT);
+    }
+
+    const Aabb& objectBounds(uint32_t object) const { return bounds[slotOf[object]]; }
+    size_t nodeCount() const { return nodes.size(); }
+    size_t objectCount() const { return bounds.size(); }
+
+    int depth() const {
+        int deepest = 0;
+        std::vector<std::pair<uint32_t, int>> stack;
+        if (!nodes.empty()) stack.push_back({ 0, 1 });
+        while (!stack.empty()) {
+            auto entry = stack.back();
+            stack.pop_back();
+            deepest = std::max(deepest, entry.second);
+            if (!nodes[entry.first].leaf()) {
+                stack.push_back({ nodes[entry.first].first, entry.second + 1 });
+                stack.push_back({ nodes[entry.first].first + 1, entry.second + 1 });
+            }
+        }
+        return deepest;
+    }
+};
+
+#endif
\ No newline at end of file
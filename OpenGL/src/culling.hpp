@@ -0,0 +1,267 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "simd.hpp"
+
+// six planes (normal, d) with normals pointing inside, p is in front of a plane when dot(normal, p) + d >= 0
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// Gribb/Hartmann: the planes are sums and differences of the rows of projection * view, normalized so that
+// plane distances come out in world units and can be compared against radii
+Frustum extractFrustum(const glm::mat4& projection, const glm::mat4& view) {
+    glm::mat4 m = projection * view;
+    auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); }; // glm is column major
+    Frustum f;
+    f.planes[0] = row(3) + row(0); // left
+    f.planes[1] = row(3) - row(0); // right
+    f.planes[2] = row(3) + row(1); // bottom
+    f.planes[3] = row(3) - row(1); // top
+    f.planes[4] = row(3) + row(2); // near
+    f.planes[5] = row(3) - row(2); // far
+    for (glm::vec4& p : f.planes) p /= glm::length(glm::vec3(p));
+    return f;
+}
+
+// bounding spheres as structure of arrays, so one load brings the same field of 4 or 8 objects
+struct SphereSoA {
+    std::vector<float> x, y, z, radius;
+
+    void add(const glm::vec3& center, float r) {
+        x.push_back(center.x);
+        y.push_back(center.y);
+        z.push_back(center.z);
+        radius.push_back(r);
+    }
+    size_t size() const { return x.size(); }
+};
+
+// axis aligned boxes as center and half extents, which turns the box test into a sphere test with a per plane radius
+struct AabbSoA {
+    std::vector<float> x, y, z, ex, ey, ez;
+
+    void add(const glm::vec3& min, const glm::vec3& max) {
+        glm::vec3 c = (min + max) * 0.5f, e = (max - min) * 0.5f;
+        x.push_back(c.x);
+        y.push_back(c.y);
+        z.push_back(c.z);
+        ex.push_back(e.x);
+        ey.push_back(e.y);
+        ez.push_back(e.z);
+    }
+    size_t size() const { return x.size(); }
+};
+
+enum class CullPath { Scalar, SSE, AVX2, NEON };
+
+const char* cullPathName(CullPath path) {
+    static const char* names[] = { "scalar", "SSE", "AVX2", "NEON" };
+    return names[(int)path];
+}
+
+bool cullPathSupported(CullPath path) {
+    switch (path) {
+    case CullPath::Scalar: return true;
+#ifdef SIMD_SSE
+    case CullPath::SSE: return true;
+#endif
+#ifdef SIMD_AVX2
+    case CullPath::AVX2: return simdHasAVX2();
+#endif
+#ifdef SIMD_NEON
+    case CullPath::NEON: return true;
+#endif
+    default: return false;
+    }
+}
+
+CullPath bestCullPath() {
+    for (CullPath path : { CullPath::AVX2, CullPath::NEON, CullPath::SSE })
+        if (cullPathSupported(path)) return path;
+    return CullPath::Scalar;
+}
+
+// the kernels below see both bound types through this, r is the sphere radius or the box x extent
+struct CullInput {
+    const float *x, *y, *z, *r, *ey, *ez;
+    size_t count;
+};
+
+// positions of the set bits of every 8 bit mask, turns a visibility mask into indices without branching
+struct CullCompactTable {
+    alignas(32) uint32_t lanes[256][8];
+    uint8_t counts[256];
+
+    CullCompactTable() {
+        for (int mask = 0; mask < 256; mask++) {
+            int n = 0;
+            for (int bit = 0; bit < 8; bit++)
+                if (mask & (1 << bit)) lanes[mask][n++] = bit;
+            for (int i = n; i < 8; i++) lanes[mask][i] = 0;
+            counts[mask] = (uint8_t)n;
+        }
+    }
+};
+
+const CullCompactTable& cullCompactTable() {
+    static const CullCompactTable table;
+    return table;
+}
+
+template <bool Box>
+size_t cullScalar(const Frustum& f, const CullInput& in, size_t begin, uint32_t* visible) {
+    size_t n = 0;
+    for (size_t i = begin; i < in.count; i++) {
+        bool inside = true;
+        for (const glm::vec4& p : f.planes) {
+            float dist = (p.x * in.x[i] + p.y * in.y[i]) + (p.z * in.z[i] + p.w); // grouped like the SIMD paths
+            float radius = Box ? std::fabs(p.x) * in.r[i] + std::fabs(p.y) * in.ey[i] + std::fabs(p.z) * in.ez[i] : in.r[i];
+            inside &= dist + radius >= 0.0f;
+        }
+        visible[n] = (uint32_t)i;
+        n += inside;
+    }
+    return n;
+}
+
+#ifdef SIMD_SSE
+template <bool Box>
+size_t cullSSE(const Frustum& f, const CullInput& in, uint32_t* visible) {
+    const CullCompactTable& table = cullCompactTable();
+    __m128 a[6], b[6], c[6], d[6], absA[6], absB[6], absC[6];
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    for (int p = 0; p < 6; p++) {
+        a[p] = _mm_set1_ps(f.planes[p].x);
+        b[p] = _mm_set1_ps(f.planes[p].y);
+        c[p] = _mm_set1_ps(f.planes[p].z);
+        d[p] = _mm_set1_ps(f.planes[p].w);
+        absA[p] = _mm_andnot_ps(signMask, a[p]);
+        absB[p] = _mm_andnot_ps(signMask, b[p]);
+        absC[p] = _mm_andnot_ps(signMask, c[p]);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    size_t n = 0, i = 0;
+    for (; i + 4 <= in.count; i += 4) {
+        __m128 x = _mm_loadu_ps(in.x + i), y = _mm_loadu_ps(in.y + i), z = _mm_loadu_ps(in.z + i), r = _mm_loadu_ps(in.r + i);
+        __m128 ey = Box ? _mm_loadu_ps(in.ey + i) : zero, ez = Box ? _mm_loadu_ps(in.ez + i) : zero;
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for (int p = 0; p < 6; p++) {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[p], x), _mm_mul_ps(b[p], y)), _mm_add_ps(_mm_mul_ps(c[p], z), d[p]));
+            __m128 radius = Box ? _mm_add_ps(_mm_add_ps(_mm_mul_ps(absA[p], r), _mm_mul_ps(absB[p], ey)), _mm_mul_ps(absC[p], ez)) : r;
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, radius), zero));
+        }
+        int mask = _mm_movemask_ps(inside);
+        __m128i lanes = _mm_load_si128((const __m128i*)table.lanes[mask]);
+        _mm_storeu_si128((__m128i*)(visible + n), _mm_add_epi32(lanes, _mm_set1_epi32((int)i)));
+        n += table.counts[mask];
+    }
+    return n + cullScalar<Box>(f, in, i, visible + n);
+}
+#endif
+
+#ifdef SIMD_AVX2
+template <bool Box>
+__attribute__((target("avx2"))) size_t cullAVX2(const Frustum& f, const CullInput& in, uint32_t* visible) {
+    const CullCompactTable& table = cullCompactTable();
+    __m256 a[6], b[6], c[6], d[6], absA[6], absB[6], absC[6];
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    for (int p = 0; p < 6; p++) {
+        a[p] = _mm256_set1_ps(f.planes[p].x);
+        b[p] = _mm256_set1_ps(f.planes[p].y);
+        c[p] = _mm256_set1_ps(f.planes[p].z);
+        d[p] = _mm256_set1_ps(f.planes[p].w);
+        absA[p] = _mm256_andnot_ps(signMask, a[p]);
+        absB[p] = _mm256_andnot_ps(signMask, b[p]);
+        absC[p] = _mm256_andnot_ps(signMask, c[p]);
+    }
+    const __m256 zero = _mm256_setzero_ps();
+    size_t n = 0, i = 0;
+    for (; i + 8 <= in.count; i += 8) {
+        __m256 x = _mm256_loadu_ps(in.x + i), y = _mm256_loadu_ps(in.y + i), z = _mm256_loadu_ps(in.z + i), r = _mm256_loadu_ps(in.r + i);
+        __m256 ey = Box ? _mm256_loadu_ps(in.ey + i) : zero, ez = Box ? _mm256_loadu_ps(in.ez + i) : zero;
+        __m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+        for (int p = 0; p < 6; p++) {
+            __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a[p], x), _mm256_mul_ps(b[p], y)), _mm256_add_ps(_mm256_mul_ps(c[p], z), d[p]));
+            __m256 radius = Box ? _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absA[p], r), _mm256_mul_ps(absB[p], ey)), _mm256_mul_ps(absC[p], ez)) : r;
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(dist, radius), zero, _CMP_GE_OQ));
+        }
+        int mask = _mm256_movemask_ps(inside);
+        __m256i lanes = _mm256_load_si256((const __m256i*)table.lanes[mask]);
+        _mm256_storeu_si256((__m256i*)(visible + n), _mm256_add_epi32(lanes, _mm256_set1_epi32((int)i)));
+        n += table.counts[mask];
+    }
+    return n + cullScalar<Box>(f, in, i, visible + n);
+}
+#endif
+
+#ifdef SIMD_NEON
+template <bool Box>
+size_t cullNEON(const Frustum& f, const CullInput& in, uint32_t* visible) {
+    const CullCompactTable& table = cullCompactTable();
+    const uint32_t bitValues[4] = { 1, 2, 4, 8 };
+    const uint32x4_t bits = vld1q_u32(bitValues);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    size_t n = 0, i = 0;
+    for (; i + 4 <= in.count; i += 4) {
+        float32x4_t x = vld1q_f32(in.x + i), y = vld1q_f32(in.y + i), z = vld1q_f32(in.z + i), r = vld1q_f32(in.r + i);
+        float32x4_t ey = Box ? vld1q_f32(in.ey + i) : zero, ez = Box ? vld1q_f32(in.ez + i) : zero;
+        uint32x4_t inside = vdupq_n_u32(~0u);
+        for (const glm::vec4& p : f.planes) {
+            float32x4_t dist = vaddq_f32(vaddq_f32(vmulq_n_f32(x, p.x), vmulq_n_f32(y, p.y)), vaddq_f32(vmulq_n_f32(z, p.z), vdupq_n_f32(p.w)));
+            float32x4_t radius = Box ? vaddq_f32(vaddq_f32(vmulq_n_f32(r, std::fabs(p.x)), vmulq_n_f32(ey, std::fabs(p.y))), vmulq_n_f32(ez, std::fabs(p.z))) : r;
+            inside = vandq_u32(inside, vcgeq_f32(vaddq_f32(dist, radius), zero));
+        }
+        uint32_t mask = vaddvq_u32(vandq_u32(inside, bits));
+        vst1q_u32(visible + n, vaddq_u32(vld1q_u32(table.lanes[mask]), vdupq_n_u32((uint32_t)i)));
+        n += table.counts[mask];
+    }
+    return n + cullScalar<Box>(f, in, i, visible + n);
+}
+#endif
+
+template <bool Box>
+size_t cullBounds(const Frustum& f, const CullInput& in, uint32_t* visible, CullPath path) {
+    switch (path) {
+#ifdef SIMD_AVX2
+    case CullPath::AVX2: return cullAVX2<Box>(f, in, visible);
+#endif
+#ifdef SIMD_SSE
+    case CullPath::SSE: return cullSSE<Box>(f, in, visible);
+#endif
+#ifdef SIMD_NEON
+    case CullPath::NEON: return cullNEON<Box>(f, in, visible);
+#endif
+    default: return cullScalar<Box>(f, in, 0, visible);
+    }
+}
+
+// writes the indices of the spheres that intersect the frustum to the front of visible in ascending order and returns
+// how many there are, conservative near the corners like any plane test. The SIMD paths store whole vectors past the
+// last visible index, so visible only ever grows and entries from the count on are garbage.
+size_t cullSpheres(const Frustum& f, const SphereSoA& bounds, std::vector<uint32_t>& visible, CullPath path = bestCullPath()) {
+    if (visible.size() < bounds.size() + 8) visible.resize(bounds.size() + 8);
+    CullInput in = { bounds.x.data(), bounds.y.data(), bounds.z.data(), bounds.radius.data(), nullptr, nullptr, bounds.size() };
+    return cullBounds<false>(f, in, visible.data(), path);
+}
+
+// the spheres in [begin, end) only, so one cull can be split across jobs. visible needs room for end - begin + 8 entries
+// and gets the same indices cullSpheres would write.
+size_t cullSphereRange(const Frustum& f, const SphereSoA& bounds, size_t begin, size_t end, uint32_t* visible, CullPath path = bestCullPath()) {
+    CullInput in = { bounds.x.data() + begin, bounds.y.data() + begin, bounds.z.data() + begin, bounds.radius.data() + begin, nullptr, nullptr, end - begin };
+    size_t count = cullBounds<false>(f, in, visible, path);
+    for (size_t i = 0; i < count; i++) visible[i] += (uint32_t)begin;
+    return count;
+}
+
+size_t cullBoxes(const Frustum& f, const AabbSoA& bounds, std::vector<uint32_t>& visible, CullPath path = bestCullPath()) {
+    if (visible.size() < bounds.size() + 8) visible.resize(bounds.size() + 8);
+    CullInput in = { bounds.x.data(), bounds.y.data(), bounds.z.data(), bounds.ex.data(), bounds.ey.data(), bounds.ez.data(), bounds.size() };
+    return cullBounds<true>(f, in, visible.data(), path);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+#ifndef DDS_FILE_H
+#define DDS_FILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+#include "bcn.hpp"
+#include "mappedFile.hpp"
+#include "mipmap.hpp"
+
+// cooked textures: DDS with the DX10 extension header, every level of the chain back to back from level 0 in the
+// block layout glCompressedTexImage2D takes. Files with the legacy DXT1/DXT5/ATI1/ATI2 pixel formats are read as well.
+const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+const uint32_t DDS_FOURCC = 0x4; // pixel format flag
+const uint32_t DDS_HEADER_FLAGS = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // caps, height, width, pixel format, mip count, linear size
+const uint32_t DDS_CAPS = 0x1000 | 0x400000 | 0x8; // texture, mipmap, complex
+const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+const int DDS_MAX_LEVELS = 16;
+
+uint32_t ddsFourCC(const char code[5]) { return (uint32_t)code[0] | (uint32_t)code[1] << 8 | (uint32_t)code[2] << 16 | (uint32_t)code[3] << 24; }
+
+struct DdsPixelFormat {
+    uint32_t size, flags, fourCC, rgbBitCount;
+    uint32_t rBitMask, gBitMask, bBitMask, aBitMask;
+};
+
+struct DdsHeader {
+    uint32_t magic;
+    uint32_t size, flags, height, width, pitchOrLinearSize, depth, mipMapCount;
+    uint32_t reserved1[11];
+    DdsPixelFormat pixelFormat;
+    uint32_t caps, caps2, caps3, caps4, reserved2;
+};
+
+struct DdsHeaderDx10 {
+    uint32_t dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2;
+};
+
+static_assert(std::is_trivially_copyable<DdsHeader>::value, "DdsHeader is read straight out of the mapping");
+static_assert(sizeof(DdsHeader) == 128 && sizeof(DdsHeaderDx10) == 20, "DDS header layout is fixed by the format");
+
+// DXGI_FORMAT of a format, the sRGB one is always the next value up
+uint32_t ddsDxgiFormat(BcnFormat format, bool srgb) {
+    switch (format) {
+    case BcnFormat::BC1: return srgb ? 72 : 71;
+    case BcnFormat::BC3: return srgb ? 78 : 77;
+    case BcnFormat::BC4: return 80;
+    case BcnFormat::BC5: return 83;
+    default: return srgb ? 99 : 98;
+    }
+}
+
+bool ddsFromDxgi(uint32_t dxgi, BcnFormat& format, bool& srgb) {
+    static const BcnFormat formats[] = { BcnFormat::BC1, BcnFormat::BC3, BcnFormat::BC4, BcnFormat::BC5, BcnFormat::BC7 };
+    for (BcnFormat candidate : formats)
+        for (int s = 0; s < 2; s++)
+            if (ddsDxgiFormat(candidate, s) == dxgi) {
+                format = candidate;
+                srgb = dxgi != ddsDxgiFormat(candidate, false);
+                return true;
+            }
+    return false;
+}
+
+struct BcnLevel {
+    size_t offset, bytes;
+    int width, height;
+};
+
+// a compressed mip chain, what textureCooker writes and loadCompressedTexture reads. Level offsets are into blocks
+// for an image built in memory and into the mapping for one read by readDdsFile.
+struct BcnImage {
+    BcnFormat format = BcnFormat::BC1;
+    bool srgb = false;
+    std::vector<BcnLevel> levels;
+    std::vector<uint8_t> blocks;
+};
+
+bool writeDdsFile(const char* path, const BcnImage& image) {
+    const BcnLevel& base = image.levels[0];
+    DdsHeader header = {};
+    header.magic = DDS_MAGIC;
+    header.size = sizeof(DdsHeader) - sizeof(header.magic);
+    header.flags = DDS_HEADER_FLAGS;
+    header.width = (uint32_t)base.width;
+    header.height = (uint32_t)base.height;
+    header.pitchOrLinearSize = (uint32_t)base.bytes;
+    header.mipMapCount = (uint32_t)image.levels.size();
+    header.pixelFormat.size = sizeof(DdsPixelFormat);
+    header.pixelFormat.flags = DDS_FOURCC;
+    header.pixelFormat.fourCC = ddsFourCC("DX10");
+    header.caps = DDS_CAPS;
+    DdsHeaderDx10 dx10 = { ddsDxgiFormat(image.format, image.srgb), DDS_DIMENSION_TEXTURE2D, 0, 1, 0 };
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        std::cout << "ERROR::DDS_FILE::OPEN_FAILED " << path << std::endl;
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(&dx10, sizeof(dx10), 1, file) == 1;
+    ok = ok && fwrite(image.blocks.data(), 1, image.blocks.size(), file) == image.blocks.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok) std::cout << "ERROR::DDS_FILE::WRITE_FAILED " << path << std::endl;
+    return ok;
+}
+
+// the CPU fallback decodes every block it is given, only BC7's reserved mode fails and those blocks come out
+// transparent black as they would on the GPU. Both upload paths report it here so the message is the same.
+bool checkBcnDecode(bool decoded, const char* path) {
+    if (!decoded) std::cout << "ERROR::TEXTURE::BC7_RESERVED_MODE " << path << std::endl;
+    return decoded;
+}
+
+// checks the header and that every level is in the file, image gets the layout with offsets into the mapping.
+// Only 2D textures in one of the BcnFormats are accepted.
+bool readDdsFile(const MappedFile& file, const char* path, BcnImage& image) {
+    if (file.size() < sizeof(DdsHeader)) {
+        std::cout << "ERROR::DDS_FILE::TRUNCATED " << path << std::endl;
+        return false;
+    }
+    const DdsHeader& header = *(const DdsHeader*)file.data();
+    if (header.magic != DDS_MAGIC || header.size != sizeof(DdsHeader) - sizeof(header.magic)) {
+        std::cout << "ERROR::DDS_FILE::BAD_MAGIC " << path << std::endl;
+        return false;
+    }
+    size_t offset = sizeof(DdsHeader);
+    uint32_t fourCC = header.pixelFormat.fourCC;
+    bool known = (header.pixelFormat.flags & DDS_FOURCC) != 0;
+    image.srgb = false;
+    if (known && fourCC == ddsFourCC("DX10")) {
+        if (file.size() < offset + sizeof(DdsHeaderDx10)) {
+            std::cout << "ERROR::DDS_FILE::TRUNCATED " << path << std::endl;
+            return false;
+        }
+        const DdsHeaderDx10& dx10 = *(const DdsHeaderDx10*)(file.data() + offset);
+        offset += sizeof(DdsHeaderDx10);
+        known = ddsFromDxgi(dx10.dxgiFormat, image.format, image.srgb) && dx10.resourceDimension == DDS_DIMENSION_TEXTURE2D && dx10.arraySize == 1;
+    } else if (known && fourCC == ddsFourCC("DXT1")) image.format = BcnFormat::BC1;
+    else if (known && fourCC == ddsFourCC("DXT5")) image.format = BcnFormat::BC3;
+    else if (known && (fourCC == ddsFourCC("ATI1") || fourCC == ddsFourCC("BC4U"))) image.format = BcnFormat::BC4;
+    else if (known && (fourCC == ddsFourCC("ATI2") || fourCC == ddsFourCC("BC5U"))) image.format = BcnFormat::BC5;
+    else known = false;
+    if (!known) {
+        std::cout << "ERROR::DDS_FILE::UNSUPPORTED_FORMAT " << path << std::endl;
+        return false;
+    }
+    int width = (int)header.width, height = (int)header.height;
+    int count = header.mipMapCount ? (int)header.mipMapCount : 1;
+    // a chain longer than the one down to 1x1 would describe levels that do not exist
+    if (width <= 0 || height <= 0 || header.depth > 1 || count > DDS_MAX_LEVELS || count > mipLevelCount(width, height)) {
+        std::cout << "ERROR::DDS_FILE::CORRUPT_HEADER " << path << std::endl;
+        return false;
+    }
+    image.levels.clear();
+    for (int level = 0; level < count; level++) {
+        size_t bytes = bcnLevelBytes(image.format, width, height);
+        image.levels.push_back({ offset, bytes, width, height });
+        offset += bytes;
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    if (offset > file.size()) {
+        std::cout << "ERROR::DDS_FILE::TRUNCATED " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,215 @@
+#ifndef GL_RESOURCE_H
+#define GL_RESOURCE_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+#include "glState.hpp"
+#include "trace.hpp"
+
+enum class GLResourceType { VertexArray, Buffer, Program, Texture, Framebuffer, Renderbuffer, Query, Sampler, Count };
+
+const char* glResourceName(GLResourceType type) {
+    static const char* names[] = { "vertex arrays", "buffers", "programs", "textures", "framebuffers", "renderbuffers", "queries", "samplers" };
+    return names[(int)type];
+}
+
+// every live GL object the wrappers own, with the bytes of storage each one was given
+class GLResourceRegistry {
+private:
+    struct Totals {
+        size_t live = 0, created = 0, bytes = 0, peakBytes = 0;
+    };
+    std::unordered_map<uint64_t, size_t> objects; // type << 32 | name -> bytes
+    Totals totals[(int)GLResourceType::Count];
+    bool contextAlive = true;
+
+    static uint64_t key(GLResourceType type, GLuint name) { return (uint64_t)type << 32 | name; }
+public:
+    void add(GLResourceType type, GLuint name) {
+        objects[key(type, name)] = 0;
+        totals[(int)type].live++;
+        totals[(int)type].created++;
+    }
+
+    void resize(GLResourceType type, GLuint name, size_t bytes) {
+        auto it = objects.find(key(type, name));
+        if (it == objects.end()) return;
+        Totals& t = totals[(int)type];
+        t.bytes = t.bytes - it->second + bytes;
+        t.peakBytes = std::max(t.peakBytes, t.bytes);
+        it->second = bytes;
+    }
+
+    // false once the context is gone, its objects died with it and must not be deleted again
+    bool remove(GLResourceType type, GLuint name) {
+        auto it = objects.find(key(type, name));
+        if (it != objects.end()) {
+            totals[(int)type].live--;
+            totals[(int)type].bytes -= it->second;
+            objects.erase(it);
+        }
+        return contextAlive;
+    }
+
+    // call right before destroying the context, wrappers that outlive it only deregister from then on
+    void contextDestroyed() { contextAlive = false; }
+    bool hasContext() const { return contextAlive; }
+
+    size_t live(GLResourceType type) const { return totals[(int)type].live; }
+    size_t bytes(GLResourceType type) const { return totals[(int)type].bytes; }
+    // what track() last reported for one object
+    size_t bytes(GLResourceType type, GLuint name) const {
+        auto it = objects.find(key(type, name));
+        return it == objects.end() ? 0 : it->second;
+    }
+
+    void print() const {
+        std::cout << std::left << std::setw(16) << "GL resources" << std::right << std::setw(8) << "live" << std::setw(10) << "created"
+                  << std::setw(14) << "KB" << std::setw(14) << "peak KB" << std::endl;
+        for (int i = 0; i < (int)GLResourceType::Count; i++) {
+            const Totals& t = totals[i];
+            std::cout << std::left << std::setw(16) << glResourceName((GLResourceType)i) << std::right << std::setw(8) << t.live
+                      << std::setw(10) << t.created << std::setw(14) << std::fixed << std::setprecision(1) << t.bytes / 1024.0
+                      << std::setw(14) << t.peakBytes / 1024.0 << std::endl;
+        }
+    }
+};
+
+// never destroyed, global wrappers may still deregister after main returns
+GLResourceRegistry& glResources() {
+    static GLResourceRegistry* registry = new GLResourceRegistry();
+    return *registry;
+}
+
+GLuint glCreateResource(GLResourceType type) {
+    GLuint name = 0;
+    switch (type) {
+    case GLResourceType::VertexArray: glGenVertexArrays(1, &name); break;
+    case GLResourceType::Buffer: glGenBuffers(1, &name); break;
+    case GLResourceType::Program: name = glCreateProgram(); break;
+    case GLResourceType::Texture: glGenTextures(1, &name); break;
+    case GLResourceType::Framebuffer: glGenFramebuffers(1, &name); break;
+    case GLResourceType::Renderbuffer: glGenRenderbuffers(1, &name); break;
+    case GLResourceType::Query: glGenQueries(1, &name); break;
+    case GLResourceType::Sampler: glGenSamplers(1, &name); break;
+    default: break;
+    }
+    return name;
+}
+
+void glDeleteResource(GLResourceType type, GLuint name) {
+    switch (type) {
+    case GLResourceType::VertexArray: glDeleteVertexArrays(1, &name); glState().vertexArrayDeleted(name); break;
+    case GLResourceType::Buffer: glDeleteBuffers(1, &name); glState().bufferDeleted(name); break;
+    case GLResourceType::Program: glDeleteProgram(name); glState().programDeleted(name); break;
+    case GLResourceType::Texture: glDeleteTextures(1, &name); glState().textureDeleted(name); break;
+    case GLResourceType::Framebuffer: glDeleteFramebuffers(1, &name); glState().framebufferDeleted(name); break;
+    case GLResourceType::Renderbuffer: glDeleteRenderbuffers(1, &name); break;
+    case GLResourceType::Query: glDeleteQueries(1, &name); break;
+    case GLResourceType::Sampler: glDeleteSamplers(1, &name); glState().samplerDeleted(name); break;
+    default: break;
+    }
+}
+
+// move-only owner of one GL object name, empty until generate()
+template <GLResourceType Type>
+class GLObject {
+private:
+    GLuint name = 0;
+public:
+    GLObject() = default;
+    GLObject(const GLObject&) = delete;
+    GLObject& operator=(const GLObject&) = delete;
+    GLObject(GLObject&& other) noexcept : name(other.name) { other.name = 0; }
+    GLObject& operator=(GLObject&& other) noexcept {
+        if (this != &other) {
+            reset();
+            name = other.name;
+            other.name = 0;
+        }
+        return *this;
+    }
+    ~GLObject() { reset(); }
+
+    // replaces whatever this held with a fresh object
+    GLuint generate() {
+        reset();
+        name = glCreateResource(Type);
+        if (name) glResources().add(Type, name);
+        return name;
+    }
+
+    void reset() {
+        if (!name) return;
+        if (glResources().remove(Type, name)) glDeleteResource(Type, name);
+        name = 0;
+    }
+
+    // storage estimate reported by the registry, exact for buffers
+    void track(size_t bytes) const {
+        if (name) glResources().resize(Type, name, bytes);
+    }
+
+    GLuint id() const { return name; }
+    explicit operator bool() const { return name != 0; }
+};
+
+class VertexArray : public GLObject<GLResourceType::VertexArray> {
+public:
+    void bind() const { glState().bindVertexArray(id()); }
+};
+
+class Buffer : public GLObject<GLResourceType::Buffer> {
+public:
+    void bind(GLenum target) const { glState().bindBuffer(target, id()); }
+
+    // binds to target and (re)allocates, generating the buffer on first use
+    void data(GLenum target, size_t bytes, const void* ptr, GLenum usage) {
+        TraceScope trace("bufferData", "upload", (int64_t)bytes);
+        if (!id()) generate();
+        glState().bindBuffer(target, id());
+        glBufferData(target, bytes, ptr, usage);
+        track(bytes);
+    }
+
+    void subData(GLenum target, size_t offset, size_t bytes, const void* ptr) const {
+        TraceScope trace("bufferSubData", "upload", (int64_t)bytes);
+        glState().bindBuffer(target, id());
+        glBufferSubData(target, offset, bytes, ptr);
+    }
+};
+
+class Program : public GLObject<GLResourceType::Program> {
+public:
+    void use() const { glState().useProgram(id()); }
+};
+
+class Texture : public GLObject<GLResourceType::Texture> {
+public:
+    void bind(GLenum target = GL_TEXTURE_2D) const { glState().bindTexture(target, id()); }
+    void bind(GLuint unit, GLenum target) const { glState().bindTexture(unit, target, id()); }
+};
+
+class Framebuffer : public GLObject<GLResourceType::Framebuffer> {
+public:
+    void bind(GLenum target = GL_FRAMEBUFFER) const { glState().bindFramebuffer(target, id()); }
+};
+
+class Renderbuffer : public GLObject<GLResourceType::Renderbuffer> {
+public:
+    void bind() const { glBindRenderbuffer(GL_RENDERBUFFER, id()); }
+};
+
+class Query : public GLObject<GLResourceType::Query> {};
+
+// sampling state on its own, overrides the parameters of whatever texture shares its unit
+class Sampler : public GLObject<GLResourceType::Sampler> {
+public:
+    void bind(GLuint unit) const { glState().bindSampler(unit, id()); }
+};
+
+#endif
\ No newline at end of file
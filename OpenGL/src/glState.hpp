@@ -0,0 +1,311 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+enum class GLStateCall { Program, VertexArray, Buffer, Texture, ActiveTexture, Sampler, Capability, Blend, Depth, Viewport, Framebuffer, Count };
+
+const char* glStateCallName(GLStateCall call) {
+    static const char* names[] = { "useProgram", "bindVertexArray", "bindBuffer", "bindTexture", "activeTexture",
+                                   "bindSampler", "enable/disable", "blendFunc", "depthFunc/Mask", "viewport", "bindFramebuffer" };
+    return names[(int)call];
+}
+
+// shadow of the binding and fixed function state of the one context, calls that would not change anything never reach
+// the driver. Everything has to go through here (the resource wrappers do), anything else must call invalidate() after.
+class GLStateCache {
+public:
+    static const int MAX_TEXTURE_UNITS = 32;
+    static const GLuint UNKNOWN = ~0u;
+
+    struct Counters {
+        size_t issued[(int)GLStateCall::Count] = {}, skipped[(int)GLStateCall::Count] = {};
+        size_t totalIssued() const { return sum(issued); }
+        size_t totalSkipped() const { return sum(skipped); }
+    private:
+        static size_t sum(const size_t* counts) {
+            size_t total = 0;
+            for (int i = 0; i < (int)GLStateCall::Count; i++) total += counts[i];
+            return total;
+        }
+    };
+private:
+    static const int BUFFER_TARGETS = 8, TEXTURE_TARGETS = 4, CAPABILITIES = 8;
+
+    GLuint program, vertexArray, drawFramebuffer, readFramebuffer;
+    GLuint buffers[BUFFER_TARGETS];
+    GLuint textures[MAX_TEXTURE_UNITS][TEXTURE_TARGETS];
+    GLuint samplers[MAX_TEXTURE_UNITS];
+    GLuint activeUnit;
+    struct Capability {
+        GLenum cap = 0;
+        int state = -1; // -1 unknown
+    } capabilities[CAPABILITIES];
+    GLenum blendSrc, blendDst, depthFn;
+    int depthWrite;
+    GLint view[4];
+    Counters frame, last, total;
+
+    static int bufferIndex(GLenum target) {
+        switch (target) {
+        case GL_ARRAY_BUFFER: return 0;
+        case GL_UNIFORM_BUFFER: return 1;
+        case GL_COPY_READ_BUFFER: return 2;
+        case GL_COPY_WRITE_BUFFER: return 3;
+        case GL_PIXEL_PACK_BUFFER: return 4;
+        case GL_PIXEL_UNPACK_BUFFER: return 5;
+        case GL_DRAW_INDIRECT_BUFFER: return 6;
+        case GL_SHADER_STORAGE_BUFFER: return 7;
+        default: return -1; // GL_ELEMENT_ARRAY_BUFFER lives in the VAO, always issued
+        }
+    }
+
+    static int textureIndex(GLenum target) {
+        switch (target) {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_CUBE_MAP: return 1;
+        case GL_TEXTURE_2D_ARRAY: return 2;
+        case GL_TEXTURE_3D: return 3;
+        default: return -1;
+        }
+    }
+
+    // true when the call has to be issued, the shadow is updated either way
+    template <typename T>
+    bool change(GLStateCall call, T& current, T value) {
+        if (enabled && current == value) {
+            frame.skipped[(int)call]++;
+            return false;
+        }
+        current = value;
+        frame.issued[(int)call]++;
+        return true;
+    }
+
+    void issued(GLStateCall call) { frame.issued[(int)call]++; }
+public:
+    // false issues every call, only useful for benchmarking
+    bool enabled = true;
+
+    GLStateCache() { invalidate(); }
+
+    // forget everything, for a new context or after raw GL calls that bypassed the cache
+    void invalidate() {
+        program = vertexArray = drawFramebuffer = readFramebuffer = activeUnit = UNKNOWN;
+        for (GLuint& b : buffers) b = UNKNOWN;
+        for (auto& unit : textures)
+            for (GLuint& t : unit) t = UNKNOWN;
+        for (GLuint& s : samplers) s = UNKNOWN;
+        for (Capability& c : capabilities) c = Capability();
+        blendSrc = blendDst = depthFn = UNKNOWN;
+        depthWrite = -1;
+        view[0] = view[1] = view[2] = view[3] = -1;
+    }
+
+    void useProgram(GLuint name) {
+        if (change(GLStateCall::Program, program, name)) glUseProgram(name);
+    }
+
+    void bindVertexArray(GLuint name) {
+        if (change(GLStateCall::VertexArray, vertexArray, name)) glBindVertexArray(name);
+    }
+
+    void bindBuffer(GLenum target, GLuint name) {
+        int index = bufferIndex(target);
+        if (index < 0) issued(GLStateCall::Buffer);
+        else if (!change(GLStateCall::Buffer, buffers[index], name)) return;
+        glBindBuffer(target, name);
+    }
+
+    // indexed bindings are not shadowed, but the generic binding they also set is
+    void bindBufferBase(GLenum target, GLuint index, GLuint name) {
+        int slot = bufferIndex(target);
+        if (slot >= 0) buffers[slot] = name;
+        issued(GLStateCall::Buffer);
+        glBindBufferBase(target, index, name);
+    }
+
+    void activeTexture(GLenum unit) {
+        if (change(GLStateCall::ActiveTexture, activeUnit, unit - GL_TEXTURE0)) glActiveTexture(unit);
+    }
+
+    // binds to the active unit like glBindTexture
+    void bindTexture(GLenum target, GLuint name) {
+        int index = textureIndex(target);
+        if (index < 0 || activeUnit >= MAX_TEXTURE_UNITS) {
+            if (index >= 0) {
+                for (auto& unit : textures) unit[index] = UNKNOWN; // active unit unknown, any of them may change
+            }
+            issued(GLStateCall::Texture);
+        } else if (!change(GLStateCall::Texture, textures[activeUnit][index], name)) return;
+        glBindTexture(target, name);
+    }
+
+    // the unit switch is only issued when the binding on that unit actually changes
+    void bindTexture(GLuint unit, GLenum target, GLuint name) {
+        int index = textureIndex(target);
+        if (enabled && index >= 0 && unit < MAX_TEXTURE_UNITS && textures[unit][index] == name) {
+            frame.skipped[(int)GLStateCall::Texture]++;
+            return;
+        }
+        activeTexture(GL_TEXTURE0 + unit);
+        bindTexture(target, name);
+    }
+
+    // 0 hands the unit back to the parameters of its textures
+    void bindSampler(GLuint unit, GLuint name) {
+        if (unit >= MAX_TEXTURE_UNITS) issued(GLStateCall::Sampler);
+        else if (!change(GLStateCall::Sampler, samplers[unit], name)) return;
+        glBindSampler(unit, name);
+    }
+
+    void setCapability(GLenum cap, bool on) {
+        Capability* slot = nullptr;
+        for (Capability& c : capabilities) {
+            if (c.cap == cap) {
+                slot = &c;
+                break;
+            }
+            if (!slot && c.cap == 0) slot = &c;
+        }
+        if (slot && slot->cap == 0) slot->cap = cap;
+        if (!slot) issued(GLStateCall::Capability);
+        else if (!change(GLStateCall::Capability, slot->state, (int)on)) return;
+        if (on) glEnable(cap);
+        else glDisable(cap);
+    }
+    void enable(GLenum cap) { setCapability(cap, true); }
+    void disable(GLenum cap) { setCapability(cap, false); }
+
+    void blendFunc(GLenum src, GLenum dst) {
+        if (enabled && blendSrc == src && blendDst == dst) {
+            frame.skipped[(int)GLStateCall::Blend]++;
+            return;
+        }
+        blendSrc = src;
+        blendDst = dst;
+        issued(GLStateCall::Blend);
+        glBlendFunc(src, dst);
+    }
+
+    void depthFunc(GLenum func) {
+        if (change(GLStateCall::Depth, depthFn, func)) glDepthFunc(func);
+    }
+
+    void depthMask(bool write) {
+        if (change(GLStateCall::Depth, depthWrite, (int)write)) glDepthMask(write ? GL_TRUE : GL_FALSE);
+    }
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        if (enabled && view[0] == x && view[1] == y && view[2] == width && view[3] == height) {
+            frame.skipped[(int)GLStateCall::Viewport]++;
+            return;
+        }
+        view[0] = x;
+        view[1] = y;
+        view[2] = width;
+        view[3] = height;
+        issued(GLStateCall::Viewport);
+        glViewport(x, y, width, height);
+    }
+
+    void bindFramebuffer(GLenum target, GLuint name) {
+        bool draw = target != GL_READ_FRAMEBUFFER, read = target != GL_DRAW_FRAMEBUFFER;
+        if (enabled && (!draw || drawFramebuffer == name) && (!read || readFramebuffer == name)) {
+            frame.skipped[(int)GLStateCall::Framebuffer]++;
+            return;
+        }
+        if (draw) drawFramebuffer = name;
+        if (read) readFramebuffer = name;
+        issued(GLStateCall::Framebuffer);
+        glBindFramebuffer(target, name);
+    }
+
+    // deleting an object unbinds it from the current context, a recycled name must not look bound
+    void programDeleted(GLuint name) {
+        if (program == name) program = UNKNOWN; // stays in use until replaced
+    }
+    void vertexArrayDeleted(GLuint name) {
+        if (vertexArray == name) vertexArray = 0;
+    }
+    void bufferDeleted(GLuint name) {
+        for (GLuint& b : buffers)
+            if (b == name) b = 0;
+    }
+    void textureDeleted(GLuint name) {
+        for (auto& unit : textures)
+            for (GLuint& t : unit)
+                if (t == name) t = 0;
+    }
+    void samplerDeleted(GLuint name) {
+        for (GLuint& s : samplers)
+            if (s == name) s = 0;
+    }
+    // points every unit that holds from at to instead, e.g. when a streamed texture takes over from its placeholder
+    void rebindTexture(GLenum target, GLuint from, GLuint to) {
+        int index = textureIndex(target);
+        if (index < 0 || from == 0) return;
+        for (GLuint unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+            if (textures[unit][index] == from) bindTexture(unit, target, to);
+    }
+    void framebufferDeleted(GLuint name) {
+        if (drawFramebuffer == name) drawFramebuffer = 0;
+        if (readFramebuffer == name) readFramebuffer = 0;
+    }
+
+    // closes the frame counters, call once at the top of every frame
+    void newFrame() {
+        for (int i = 0; i < (int)GLStateCall::Count; i++) {
+            total.issued[i] += frame.issued[i];
+            total.skipped[i] += frame.skipped[i];
+        }
+        last = frame;
+        frame = Counters();
+    }
+
+    const Counters& lastFrame() const { return last; }
+    const Counters& currentFrame() const { return frame; }
+
+    static void print(const Counters& counters, const char* label) {
+        std::cout << std::left << std::setw(20) << label << std::right << std::setw(10) << "issued" << std::setw(10) << "skipped" << std::endl;
+        for (int i = 0; i < (int)GLStateCall::Count; i++) {
+            if (!counters.issued[i] && !counters.skipped[i]) continue;
+            std::cout << std::left << std::setw(20) << glStateCallName((GLStateCall)i) << std::right << std::setw(10) << counters.issued[i]
+                      << std::setw(10) << counters.skipped[i] << std::endl;
+        }
+        std::cout << std::left << std::setw(20) << "all" << std::right << std::setw(10) << counters.totalIssued() << std::setw(10)
+                  << counters.totalSkipped() << std::endl;
+    }
+
+    void print() const {
+        print(last, "GL state, last frame");
+        print(total, "GL state, all frames");
+    }
+};
+
+// never destroyed, like glResources
+GLStateCache& glState() {
+    static GLStateCache* cache = new GLStateCache();
+    return *cache;
+}
+
+// version of the current context, the 3.3 core contexts main creates by default already have GL_MAJOR_VERSION
+bool glVersionAtLeast(int major, int minor) {
+    GLint contextMajor = 0, contextMinor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+    glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+    return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
+bool hasGLExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+        if (!strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name)) return true;
+    return false;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,263 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "glResource.hpp"
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#define HEADLESS_EGL 1 // link with -lEGL
+#endif
+
+// GL context without a display: surfaceless EGL on Linux (Mesa llvmpipe is enough), a hidden GLFW window elsewhere
+class HeadlessContext {
+private:
+#ifdef HEADLESS_EGL
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+
+    static EGLDisplay surfacelessDisplay() {
+        const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay && clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless"))
+            return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+#endif
+    GLFWwindow* window = nullptr;
+public:
+    HeadlessContext() = default;
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+    ~HeadlessContext() { destroy(); }
+
+    // also initialises GLFW, the draw code keeps reading glfwGetTime
+    bool create(int major, int minor) {
+#ifdef HEADLESS_EGL
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        if (!glfwInit()) {
+            std::cerr << "ERROR::HEADLESS::GLFW_INIT_FAILED" << std::endl;
+            return false;
+        }
+        display = surfacelessDisplay();
+        EGLint eglMajor, eglMinor;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &eglMajor, &eglMinor)) {
+            std::cerr << "ERROR::HEADLESS::EGL_INIT_FAILED" << std::endl;
+            return false;
+        }
+        const EGLint configAttribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        EGLConfig config;
+        EGLint configCount = 0;
+        eglBindAPI(EGL_OPENGL_API);
+        if (!eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0) {
+            std::cerr << "ERROR::HEADLESS::NO_EGL_CONFIG" << std::endl;
+            return false;
+        }
+        const EGLint contextAttribs[] = { EGL_CONTEXT_MAJOR_VERSION, major, EGL_CONTEXT_MINOR_VERSION, minor,
+                                          EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+        // no surface at all, everything is drawn into a RenderTarget
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            std::cerr << "ERROR::HEADLESS::EGL_CONTEXT_FAILED" << std::endl;
+            return false;
+        }
+        if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+            std::cerr << "Failed to initialize GLAD" << std::endl;
+            return false;
+        }
+#else
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW" << std::endl;
+            return false;
+        }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(64, 64, "headless", NULL, NULL);
+        if (!window) {
+            std::cerr << "ERROR::HEADLESS::HIDDEN_WINDOW_FAILED" << std::endl;
+            return false;
+        }
+        glfwMakeContextCurrent(window);
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cerr << "Failed to initialize GLAD" << std::endl;
+            return false;
+        }
+#endif
+        std::cout << "headless " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << std::endl;
+        return true;
+    }
+
+    // GLFW itself is left to glfwTerminate
+    void destroy() {
+#ifdef HEADLESS_EGL
+        if (display != EGL_NO_DISPLAY) {
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+            eglTerminate(display);
+        }
+        display = EGL_NO_DISPLAY;
+        context = EGL_NO_CONTEXT;
+#endif
+        if (window) glfwDestroyWindow(window);
+        window = nullptr;
+    }
+};
+
+// color + depth/stencil framebuffer standing in for the default one
+class RenderTarget {
+private:
+    Framebuffer fbo;
+    Renderbuffer color, depth;
+public:
+    int width = 0, height = 0;
+
+    bool create(int w, int h) {
+        width = w;
+        height = h;
+        fbo.generate();
+        fbo.bind();
+        color.generate();
+        color.bind();
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        color.track((size_t)width * height * 4);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color.id());
+        depth.generate();
+        depth.bind();
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        depth.track((size_t)width * height * 4);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth.id());
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "ERROR::FRAMEBUFFER::INCOMPLETE " << width << "x" << height << std::endl;
+            return false;
+        }
+        glState().viewport(0, 0, width, height);
+        return true;
+    }
+
+    void bind() const {
+        fbo.bind();
+        glState().viewport(0, 0, width, height);
+    }
+
+    // binary PPM of the color attachment, flipped to top row first
+    bool writePPM(const char* path) const {
+        std::vector<unsigned char> pixels((size_t)width * height * 3);
+        fbo.bind(GL_READ_FRAMEBUFFER);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+        FILE* file = fopen(path, "wb");
+        if (!file) {
+            std::cerr << "ERROR::RENDER_TARGET::OPEN_FAILED " << path << std::endl;
+            return false;
+        }
+        fprintf(file, "P6\n%d %d\n255\n", width, height);
+        for (int y = height - 1; y >= 0; y--) fwrite(&pixels[(size_t)y * width * 3], 1, (size_t)width * 3, file);
+        fclose(file);
+        return true;
+    }
+};
+
+struct HeadlessStats {
+    // per frame: cpu is submission only, frame is start to start and includes waiting on the GPU through the query ring.
+    // gpu is NaN where the timestamps could not be believed, see runHeadless
+    std::vector<double> cpuMs, gpuMs, frameMs;
+    double wallSeconds = 0.0;
+    int rejectedGpu = 0;
+};
+
+// times frame() between two GL_TIMESTAMP counters like the profiler, each pair is read RING frames late so the CPU
+// only blocks once it runs that far ahead. The frame is flushed before the closing counter so a driver that only
+// starts work on a flush still does it inside the pair. A zero interval or one longer than the frame-to-frame time
+// cannot be a GPU time and is dropped. Software rasterizers like llvmpipe stamp on the CPU when the counter is
+// processed, not when the work ran, so even what survives there is only a rough upper bound.
+HeadlessStats runHeadless(int frames, const std::function<void()>& frame) {
+    const int RING = 4;
+    Query queries[RING][2];
+    for (Query* pair : queries)
+        for (int i = 0; i < 2; i++) pair[i].generate();
+    HeadlessStats stats;
+    stats.cpuMs.reserve(frames);
+    stats.frameMs.reserve(frames);
+    stats.gpuMs.assign(frames, std::nan(""));
+    // frameMs[f] exists once frame f + 1 has started, which collect's RING frame lag guarantees
+    auto collect = [&](int f) {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(queries[f % RING][0].id(), GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(queries[f % RING][1].id(), GL_QUERY_RESULT, &end);
+        double ms = end > begin ? (end - begin) / 1e6 : 0.0;
+        if (ms > 0.0 && ms <= stats.frameMs[f]) stats.gpuMs[f] = ms;
+        else stats.rejectedGpu++;
+    };
+    auto wallStart = std::chrono::steady_clock::now();
+    auto lastStart = wallStart;
+    for (int f = 0; f < frames; f++) {
+        if (f >= RING) collect(f - RING);
+        auto start = std::chrono::steady_clock::now();
+        if (f > 0) stats.frameMs.push_back(std::chrono::duration<double, std::milli>(start - lastStart).count());
+        lastStart = start;
+        glQueryCounter(queries[f % RING][0].id(), GL_TIMESTAMP);
+        frame();
+        stats.cpuMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        glFlush();
+        glQueryCounter(queries[f % RING][1].id(), GL_TIMESTAMP);
+    }
+    glFinish();
+    auto end = std::chrono::steady_clock::now();
+    if (frames > 0) stats.frameMs.push_back(std::chrono::duration<double, std::milli>(end - lastStart).count());
+    stats.wallSeconds = std::chrono::duration<double>(end - wallStart).count();
+    for (int f = std::max(0, frames - RING); f < frames; f++) collect(f);
+    return stats;
+}
+
+void printHeadlessStats(const HeadlessStats& stats, int width, int height, bool perFrame) {
+    if (perFrame) {
+        std::cout << "frame,cpu_ms,gpu_ms,frame_ms" << std::endl;
+        for (size_t f = 0; f < stats.cpuMs.size(); f++) {
+            std::cout << f << "," << stats.cpuMs[f] << ",";
+            if (std::isnan(stats.gpuMs[f])) std::cout << "n/a";
+            else std::cout << stats.gpuMs[f];
+            std::cout << "," << stats.frameMs[f] << std::endl;
+        }
+    }
+    // frame 0 carries shader compilation and first uploads, it is left out of the summary
+    auto summary = [](const char* label, const std::vector<double>& all) {
+        if (all.size() < 2) return;
+        std::vector<double> samples;
+        for (size_t f = 1; f < all.size(); f++)
+            if (!std::isnan(all[f])) samples.push_back(all[f]);
+        if (samples.empty()) {
+            std::cout << std::left << std::setw(6) << label << std::right << " n/a" << std::endl;
+            return;
+        }
+        std::sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (double s : samples) total += s;
+        std::cout << std::left << std::setw(6) << label << std::right << std::fixed << std::setprecision(4)
+                  << " avg " << total / samples.size() << " ms  min " << samples.front() << " ms  median "
+                  << samples[samples.size() / 2] << " ms  max " << samples.back() << " ms" << std::endl;
+    };
+    size_t frames = stats.cpuMs.size();
+    std::cout << frames << " frames at " << width << "x" << height << std::endl;
+    summary("cpu", stats.cpuMs);
+    summary("gpu", stats.gpuMs);
+    if (stats.rejectedGpu) std::cout << "      " << stats.rejectedGpu << " gpu times rejected as zero or longer than their frame" << std::endl;
+    summary("frame", stats.frameMs);
+    double fps = stats.wallSeconds > 0.0 ? frames / stats.wallSeconds : 0.0;
+    std::cout << std::setprecision(1) << fps << " frames/s, " << fps * width * height / 1e6 << " Mpixels/s" << std::endl;
+}
+
+#endif
\ No newline at end of file
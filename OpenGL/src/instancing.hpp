@@ -0,0 +1,59 @@
+#ifndef INSTANCING_H
+#define INSTANCING_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+#include "glResource.hpp"
+#include "transform.hpp"
+
+// attribute locations used by shaders/fullVtxInstanced.glsl, a mat4 takes 4 consecutive slots and a mat3 takes 3
+const unsigned int INSTANCE_MODEL_LOCATION = 3;
+const unsigned int INSTANCE_NORMAL_LOCATION = 7;
+
+struct InstanceData {
+    glm::mat4 model;
+    glm::mat3 normal;
+};
+
+InstanceData makeInstance(const glm::mat4& model) {
+    return { model, normalMatrix(model) };
+}
+
+// per-instance attribute stream, refilled from the CPU every frame and drawn with one instanced call
+class InstanceBuffer {
+private:
+    Buffer buffer;
+    size_t capacity = 0;
+public:
+    std::vector<InstanceData> instances;
+
+    // adds the instance attributes to an existing mesh VAO, its per-vertex attributes are left untouched
+    void attach(unsigned int VAO) {
+        if (!buffer) buffer.generate();
+        glState().bindVertexArray(VAO);
+        buffer.bind(GL_ARRAY_BUFFER);
+        for (unsigned int col = 0; col < 4; col++) {
+            glVertexAttribPointer(INSTANCE_MODEL_LOCATION + col, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offsetof(InstanceData, model) + col * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(INSTANCE_MODEL_LOCATION + col);
+            glVertexAttribDivisor(INSTANCE_MODEL_LOCATION + col, 1);
+        }
+        for (unsigned int col = 0; col < 3; col++) {
+            glVertexAttribPointer(INSTANCE_NORMAL_LOCATION + col, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offsetof(InstanceData, normal) + col * sizeof(glm::vec3)));
+            glEnableVertexAttribArray(INSTANCE_NORMAL_LOCATION + col);
+            glVertexAttribDivisor(INSTANCE_NORMAL_LOCATION + col, 1);
+        }
+    }
+
+    // orphans the old storage so the driver never waits on last frame's instances
+    void upload() {
+        if (instances.size() > capacity) capacity = instances.size();
+        buffer.data(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+        buffer.subData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(InstanceData), instances.data());
+    }
+
+    GLsizei count() const { return (GLsizei)instances.size(); }
+};
+
+#endif
\ No newline at end of file
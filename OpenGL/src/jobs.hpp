@@ -0,0 +1,196 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "trace.hpp"
+
+// what a group of jobs is waited on through. A job spawning into its own counter adds a child: the child is counted
+// before the parent returns, so the counter only reaches zero once the parent and everything it spawned are done.
+struct JobCounter {
+    std::atomic<uint32_t> pending{ 0 };
+
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+struct Job {
+    std::function<void()> task;
+    JobCounter* counter;
+    const char* name; // literal, shows up in --trace captures
+};
+
+// one per thread. The owner pushes and pops at the back, newest first while its data is still in cache, thieves take
+// the oldest job from the front, which for a recursive split is the biggest piece left. Jobs here are coarse
+// (thousands of objects each), so a short lock per deque costs nothing measurable next to a lock free Chase-Lev deque.
+class JobDeque {
+private:
+    std::mutex mutex;
+    std::deque<Job> jobs;
+public:
+    void push(Job&& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+
+    bool pop(Job& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) return false;
+        job = std::move(jobs.back());
+        jobs.pop_back();
+        return true;
+    }
+
+    bool steal(Job& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) return false;
+        job = std::move(jobs.front());
+        jobs.pop_front();
+        return true;
+    }
+};
+
+struct JobStats {
+    uint64_t jobs = 0, steals = 0;
+};
+
+// fixed pool of worker threads plus the thread that created the system, which only runs jobs while it waits.
+// Jobs are spawned from that thread or from inside other jobs, never from unrelated threads. Nothing in a job
+// may touch GL, submission stays on the context thread.
+class JobSystem {
+private:
+    struct ThreadSlot {
+        const JobSystem* system = nullptr;
+        unsigned index = 0;
+    };
+    std::vector<std::unique_ptr<JobDeque>> deques; // 0 belongs to the creating thread
+    std::vector<std::thread> workers;
+    std::atomic<bool> running{ true };
+    std::atomic<uint32_t> queued{ 0 }, sleepers{ 0 };
+    std::atomic<uint64_t> executed{ 0 }, stolen{ 0 };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+
+    static ThreadSlot& slot() {
+        thread_local ThreadSlot local;
+        return local;
+    }
+
+    unsigned threadIndex() const {
+        const ThreadSlot& local = slot();
+        return local.system == this ? local.index : 0;
+    }
+
+    // own deque first, then every other one starting at the neighbour
+    bool next(unsigned self, Job& job) {
+        bool found = deques[self]->pop(job);
+        for (size_t i = 1; !found && i < deques.size(); i++) {
+            found = deques[(self + i) % deques.size()]->steal(job);
+            if (found) stolen.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (found) queued.fetch_sub(1);
+        return found;
+    }
+
+    void execute(Job& job) {
+        int64_t start = tracer().active() ? Tracer::now() : 0;
+        job.task();
+        if (start) tracer().complete(job.name, "job", start, Tracer::now() - start);
+        executed.fetch_add(1, std::memory_order_relaxed);
+        job.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void workerLoop(unsigned index) {
+        slot() = { this, index };
+        Job job;
+        while (running.load(std::memory_order_relaxed)) {
+            if (next(index, job)) {
+                execute(job);
+                continue;
+            }
+            // frame work comes in bursts, spin a little before going to sleep
+            bool work = false;
+            for (int spin = 0; spin < 64 && !work; spin++) {
+                std::this_thread::yield();
+                work = queued.load() > 0;
+            }
+            if (work) continue;
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepers.fetch_add(1);
+            wake.wait(lock, [this]() { return !running.load() || queued.load() > 0; });
+            sleepers.fetch_sub(1);
+        }
+    }
+
+    template <typename F>
+    void splitRange(JobCounter& counter, size_t begin, size_t end, size_t grain, const F& fn, const char* name) {
+        while (end - begin > grain) {
+            size_t mid = begin + (end - begin) / 2;
+            spawn(counter, [this, &counter, mid, end, grain, &fn, name]() { splitRange(counter, mid, end, grain, fn, name); }, name);
+            end = mid;
+        }
+        fn(begin, end);
+    }
+public:
+    // threads counts the creating thread, 0 is one per core
+    explicit JobSystem(unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; i++) deques.emplace_back(new JobDeque());
+        for (unsigned i = 1; i < threads; i++) workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            running = false;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    void spawn(JobCounter& counter, std::function<void()> task, const char* name = "job") {
+        counter.pending.fetch_add(1, std::memory_order_relaxed);
+        deques[threadIndex()]->push({ std::move(task), &counter, name });
+        queued.fetch_add(1);
+        // a sleeper bumps sleepers before checking queued, so one of the two sides always sees the other
+        if (sleepers.load() > 0) {
+            { std::lock_guard<std::mutex> lock(sleepMutex); }
+            wake.notify_one();
+        }
+    }
+
+    // runs queued jobs until counter is done instead of blocking, so waiting inside a job cannot starve the pool
+    void wait(JobCounter& counter) {
+        unsigned self = threadIndex();
+        Job job;
+        while (!counter.done()) {
+            if (next(self, job)) execute(job);
+            else std::this_thread::yield();
+        }
+    }
+
+    // fn(begin, end) over [0, count) in ranges of at most grain, halved recursively so the first steals take the big halves.
+    // Returns once every range ran, fn is shared by all threads.
+    template <typename F>
+    void parallelFor(size_t count, size_t grain, const F& fn, const char* name = "parallelFor") {
+        if (count == 0) return;
+        JobCounter counter;
+        splitRange(counter, 0, count, std::max<size_t>(grain, 1), fn, name);
+        wait(counter);
+    }
+
+    unsigned threadCount() const { return (unsigned)deques.size(); }
+    JobStats stats() const { return { executed.load(), stolen.load() }; }
+};
+
+#endif
\ No newline at end of file
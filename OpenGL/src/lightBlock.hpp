@@ -0,0 +1,83 @@
+#ifndef LIGHTBLOCK_H
+#define LIGHTBLOCK_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "glResource.hpp"
+#include "shader.hpp"
+
+const int NR_POINT_LIGHTS = 4;
+
+// uniform buffer binding point every lighting program reads LightBlock from
+const unsigned int LIGHT_BLOCK_BINDING = 0;
+
+// C++ mirrors of the std140 structs in shaders/lightTypes/combined.glsl, vec3 occupies 16 bytes unless a float follows it
+struct DirLightStd140 {
+    glm::vec3 direction; float pad0;
+    glm::vec3 ambient; float pad1;
+    glm::vec3 diffuse; float pad2;
+    glm::vec3 specular; float pad3;
+};
+
+struct PointLightStd140 {
+    glm::vec3 position; float constant;
+    glm::vec3 ambient; float linear;
+    glm::vec3 diffuse; float quadratic;
+    glm::vec3 specular; float pad0;
+};
+
+struct FlashLightStd140 {
+    glm::vec3 ambient; float innerCone;
+    glm::vec3 diffuse; float outerCone;
+    glm::vec3 specular; float constant;
+    float linear; float quadratic; float pad0[2];
+};
+
+struct LightBlock {
+    DirLightStd140 dirLight;
+    PointLightStd140 pointLights[NR_POINT_LIGHTS];
+    FlashLightStd140 flashLight;
+};
+
+static_assert(sizeof(DirLightStd140) == 64, "DirLight must match std140");
+static_assert(sizeof(PointLightStd140) == 64, "PointLight must match std140");
+static_assert(sizeof(FlashLightStd140) == 64, "FlashLight must match std140");
+static_assert(offsetof(LightBlock, pointLights) == 64, "LightBlock must match std140");
+static_assert(offsetof(LightBlock, flashLight) == 64 + 64 * NR_POINT_LIGHTS, "LightBlock must match std140");
+
+// owns the uniform buffer behind LightBlock, edits go to the CPU copy and reach the GPU in one upload on sync()
+class LightBuffer {
+private:
+    Buffer buffer;
+    bool dirty = true;
+public:
+    LightBlock data = {};
+
+    void init() {
+        if (buffer) return;
+        buffer.data(GL_UNIFORM_BUFFER, sizeof(LightBlock), NULL, GL_DYNAMIC_DRAW);
+        glState().bindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, buffer.id());
+        dirty = true;
+    }
+
+    // point a program's LightBlock at the shared binding, GLSL 330 cannot declare the binding itself
+    void attach(const Shader& shader) const {
+        unsigned int index = glGetUniformBlockIndex(shader.id(), "LightBlock");
+        if (index != GL_INVALID_INDEX) glUniformBlockBinding(shader.id(), index, LIGHT_BLOCK_BINDING);
+    }
+
+    LightBlock& edit() {
+        dirty = true;
+        return data;
+    }
+
+    // at most one glBufferSubData per call, nothing when no light changed
+    void sync() {
+        if (!dirty || !buffer) return;
+        buffer.subData(GL_UNIFORM_BUFFER, 0, sizeof(LightBlock), &data);
+        dirty = false;
+    }
+};
+
+#endif
\ No newline at end of file
@@ -1,11 +1,17 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <memory>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "camera.hpp"
 #include "samples.hpp"
+#include "bench.hpp"
+#include "headless.hpp"
 
 struct MouseInput {
     Camera* cam;
@@ -14,12 +20,18 @@ struct MouseInput {
     float lastY = 300.0f;
 };
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) { glViewport(0, 0, width, height); }
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) { glState().viewport(0, 0, width, height); }
 
 void error_callback(int error, const char* description) { std::cerr << "GLFW Error: " << description << std::endl; }
 
-void processInput(GLFWwindow *window, float &visibilityRatio, Camera &cam, float deltaTime)
+void processInput(GLFWwindow *window, float &visibilityRatio, Camera &cam, float deltaTime, const char* tracePath)
 {
+    // T starts a trace capture and writes it on the next press, only on the press edge
+    static bool traceKeyDown = false;
+    bool traceKey = glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+    if (traceKey && !traceKeyDown) tracer().toggle(tracePath);
+    traceKeyDown = traceKey;
+
     if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, true);
     } else if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
@@ -43,6 +55,19 @@ void processInput(GLFWwindow *window, float &visibilityRatio, Camera &cam, float
     }
 }
 
+// prints the party cube under the crosshair on the press edge of the left button
+void pickOnClick(GLFWwindow* window, Camera& cam, const Bvh& bvh) {
+    static bool buttonDown = false;
+    bool button = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+    if (button && !buttonDown) {
+        float distance;
+        int picked = pickParty(cam, bvh, distance);
+        if (picked < 0) std::cout << "picked nothing" << std::endl;
+        else std::cout << "picked cube " << picked << " at " << distance << std::endl;
+    }
+    buttonDown = button;
+}
+
 void mouseCallback(GLFWwindow* window, double xpos, double ypos) {
     MouseInput* input = static_cast<MouseInput*>(glfwGetWindowUserPointer(window));
     if (input && input->cam) {
@@ -66,37 +91,111 @@ void scrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
     if (input && input->cam) input->cam->processMouseScroll(yoffset);
 }
 
-int main() {
-    glfwSetErrorCallback(error_callback);
+// wrappers still alive in main outlive the context, they must only deregister after this
+void shutdownGL(bool printResources, HeadlessContext& headlessContext) {
+    if (printResources) {
+        glResources().print();
+        glState().print();
+        textureCache().print();
+    }
+    if (profiler().enabled) profiler().print();
+    tracer().stop();
+    glResources().contextDestroyed();
+    headlessContext.destroy();
+    glfwTerminate();
+}
 
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
+int main(int argc, char** argv) {
+    const char* benchName = nullptr;
+    int frames = 500;
+    unsigned int cubes = 10;
+    bool instanced = false, quantize = false, printResources = false, headless = false, queued = false, indirect = false, arena = false, cull = false, useBvh = false;
+    bool asyncTextures = false;
+    int width = 800, height = 600;
+    int glMajor = 3, glMinor = 3;
+    const char* asset = nullptr;
+    const char* screenshot = nullptr;
+    const char* tracePath = "trace.json";
+    int traceFrames = -1;
+    int jobThreads = -1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--bench") && i + 1 < argc) benchName = argv[++i];
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc) frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--cubes") && i + 1 < argc) cubes = (unsigned int)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--instanced")) instanced = true;
+        else if (!strcmp(argv[i], "--queue")) queued = true;
+        else if (!strcmp(argv[i], "--indirect")) indirect = true;
+        else if (!strcmp(argv[i], "--arena")) arena = true;
+        else if (!strcmp(argv[i], "--cull")) cull = true;
+        else if (!strcmp(argv[i], "--bvh")) useBvh = true;
+        else if (!strcmp(argv[i], "--jobs") && i + 1 < argc) jobThreads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--gl") && i + 1 < argc) sscanf(argv[++i], "%d.%d", &glMajor, &glMinor);
+        else if (!strcmp(argv[i], "--quantize")) quantize = true;
+        else if (!strcmp(argv[i], "--async-textures")) asyncTextures = true;
+        else if (!strcmp(argv[i], "--cooked-textures")) partyCookedMaps = true;
+        else if (!strcmp(argv[i], "--decompress-textures")) forceTextureDecompression = true;
+        else if (!strcmp(argv[i], "--anisotropy") && i + 1 < argc) partyAnisotropy = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--resources")) printResources = true;
+        else if (!strcmp(argv[i], "--asset") && i + 1 < argc) asset = argv[++i];
+        else if (!strcmp(argv[i], "--headless")) headless = true;
+        else if (!strcmp(argv[i], "--width") && i + 1 < argc) width = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--height") && i + 1 < argc) height = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--screenshot") && i + 1 < argc) screenshot = argv[++i];
+        else if (!strcmp(argv[i], "--profile") && i + 1 < argc) {
+            // summary every N frames, 0 only prints it on exit
+            profiler().enabled = true;
+            profiler().reportEvery = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            tracePath = argv[++i];
+            if (traceFrames < 0) traceFrames = 0;
+        }
+        else if (!strcmp(argv[i], "--trace-frames") && i + 1 < argc) traceFrames = atoi(argv[++i]);
     }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwSetErrorCallback(error_callback);
 
-    GLFWwindow* window = glfwCreateWindow(800, 600, "LearnOpenGL", NULL, NULL);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
+    // --headless renders into an offscreen target instead of a window, see headless.hpp
+    HeadlessContext headlessContext;
+    RenderTarget target;
+    GLFWwindow* window = nullptr;
+    if (headless) {
+        if (!headlessContext.create(glMajor, glMinor) || !target.create(width, height)) {
+            shutdownGL(printResources, headlessContext);
+            return -1;
+        }
+    } else {
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW" << std::endl;
+            return -1;
+        }
 
-    glfwMakeContextCurrent(window);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, glMajor);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, glMinor);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
+        window = glfwCreateWindow(800, 600, "LearnOpenGL", NULL, NULL);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
 
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwMakeContextCurrent(window);
+
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cerr << "Failed to initialize GLAD" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    }
+    // --trace captures from startup, --trace-frames bounds it, otherwise T toggles a capture at runtime
+    if (traceFrames >= 0) tracer().start(tracePath, traceFrames);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glEnable(GL_DEPTH_TEST);
+    glState().enable(GL_DEPTH_TEST);
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     // Shader shader("../src/shaders/fullVtx.glsl", "../src/shaders/textureEx.glsl");
     // tutTexture(shader);
@@ -110,26 +209,106 @@ int main() {
     float visibilityRatio = 0.5f;
 
     Camera cam(glm::vec3(0.0f, 0.0f, 3.0f), -90.0f, 0.0f, false);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     MouseInput mouseInput = { &cam };
-    glfwSetWindowUserPointer(window, &mouseInput);
-    glfwSetCursorPosCallback(window, mouseCallback);
-    glfwSetScrollCallback(window, scrollCallback);
+    if (window) {
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        glfwSetWindowUserPointer(window, &mouseInput);
+        glfwSetCursorPosCallback(window, mouseCallback);
+        glfwSetScrollCallback(window, scrollCallback);
+    }
     float deltaTime = 0.0f;
     float lastFrame = 0.0f;
-    auto handles = prepPartyCL();
+    // --async-textures streams the party maps in behind placeholders instead of loading them before the first frame
+    std::unique_ptr<TextureLoader> textureLoader;
+    if (asyncTextures) textureLoader.reset(new TextureLoader());
+    textureCache().loader = textureLoader.get();
+    auto handles = prepPartyCL(quantize);
     // auto handles = prepParty("spot");
     auto lightSrcShader = prepStaticLightSrc();
 
+    if (benchName) {
+        BenchContext ctx = { cam, handles.first, lightSrcShader, handles.second, frames, cubes, asset };
+        bool ran = runBench(benchName, ctx);
+        shutdownGL(printResources, headlessContext);
+        return ran ? 0 : -1;
+    }
+    // --asset swaps the party cube for any OBJ model or cooked .mesh file
+    size_t assetLength = asset ? strlen(asset) : 0;
+    bool cookedAsset = assetLength > 5 && !strcmp(asset + assetLength - 5, ".mesh");
+    if (asset && !(cookedAsset ? loadMeshFile(asset, handles.second) : createObjMesh(asset, handles.second, true, quantize))) {
+        shutdownGL(printResources, headlessContext);
+        return -1;
+    }
+    if (handles.second.quantized && !quantize) {
+        std::cerr << asset << " is quantized, run with --quantize" << std::endl;
+        shutdownGL(printResources, headlessContext);
+        return -1;
+    }
+    if (asset && quantize) {
+        handles.first.use();
+        setVertexDecode(handles.first, handles.second.decode);
+    }
+    InstanceBuffer instances;
+    std::pair<Shader, Mesh> instancedHandles;
+    if (instanced) instancedHandles = prepPartyCLInstanced(instances);
+    // --indirect packs the cubes into one IndirectBatch, drawn with glMultiDrawElementsIndirect on --gl 4.3 and up
+    std::pair<Shader, IndirectBatch> indirectHandles;
+    if (indirect) indirectHandles = prepPartyIndirect(cubes);
+    // --arena draws the float cube out of a shared MeshArena page
+    MeshArena meshArena;
+    uint32_t arenaCube = arena ? createArenaMesh(meshArena, defCubeWithNormTex, sizeof(defCubeWithNormTex), true, true) : 0;
+    // --cull skips the cubes outside the view frustum
+    SphereSoA partyCullBounds;
+    std::vector<uint32_t> visibleCubes;
+    if (cull || jobThreads >= 0) partyCullBounds = partyBounds(cubes);
+    // --jobs N culls and builds the cube draws on N threads (0 is one per core), only the GL calls stay on this one
+    JobSystem jobs(jobThreads < 0 ? 1 : jobThreads);
+    PartyFrame partyFrame;
+    // --bvh culls through a refitted BVH instead, and a left click picks the cube under the crosshair
+    Bvh partyBvh;
+    if (useBvh) partyBvh = buildPartyBvh(cubes);
+    // lightSrc.glsl reads plain float positions
+    Mesh floatCube;
+    if (handles.second.quantized) floatCube = createIndexedCubeWithNormTex();
+    const Mesh& lightMesh = handles.second.quantized ? floatCube : handles.second;
+    // --queue submits the same scene to a sorted RenderQueue instead of drawing it in call order
+    RenderQueue queue;
+    PartyMaterials partyMaterials = addPartyMaterials(queue, handles.first, lightSrcShader);
+
+    auto drawScene = [&]() {
+        profiler().newFrame();
+        glState().newFrame();
+        if (textureLoader) textureLoader->update();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (queued) drawPartyQueued(cam, queue, partyMaterials, lightMesh, handles.second, cubes);
+        else {
+            drawPtLights(cam, lightMesh, lightSrcShader);
+            if (instanced) drawPartyCLInstanced(cam, instancedHandles.second, instancedHandles.first, instances, cubes);
+            else if (jobThreads >= 0) drawPartyParallel(cam, handles.second, handles.first, partyCullBounds, jobs, partyFrame);
+            else if (useBvh) drawPartyBvh(cam, handles.second, handles.first, partyBvh, visibleCubes);
+            else if (cull) drawPartyCulled(cam, handles.second, handles.first, partyCullBounds, visibleCubes);
+            else if (arena) drawPartyArena(cam, meshArena, arenaCube, handles.first, cubes);
+            else if (indirect) drawPartyIndirect(cam, indirectHandles.second, indirectHandles.first);
+            else drawPartyCL(cam, handles.second, handles.first, cubes);
+        }
+    };
+
+    if (headless) {
+        target.bind();
+        printHeadlessStats(runHeadless(frames, drawScene), width, height, true);
+        bool saved = !screenshot || target.writePPM(screenshot);
+        shutdownGL(printResources, headlessContext);
+        return saved ? 0 : -1;
+    }
+
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
-        processInput(window, visibilityRatio, cam, deltaTime);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        drawPtLights(cam, handles.second[0], lightSrcShader);
-        drawPartyCL(cam, handles.second[0], handles.first);
-        // drawLight(cam, handles.second[0], lightSrcShader);
+        processInput(window, visibilityRatio, cam, deltaTime, tracePath);
+        if (useBvh) pickOnClick(window, cam, partyBvh);
+        drawScene();
+        // drawLight(cam, handles.second, lightSrcShader);
         // shader.setFloat("visibilityRatio", visibilityRatio);
 
         // glm::mat4 trans = glm::mat4(1.0f);
@@ -171,6 +350,6 @@ int main() {
         glfwPollEvents();
     }
 
-    glfwTerminate();
+    shutdownGL(printResources, headlessContext);
     return 0;
 }
\ No newline at end of file
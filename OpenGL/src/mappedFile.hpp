@@ -0,0 +1,63 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// read-only memory map of a whole file, pages are faulted in lazily by whoever touches them
+class MappedFile {
+private:
+    void* ptr = nullptr;
+    size_t length = 0;
+public:
+    MappedFile() = default;
+    MappedFile(const char* path) { open(path); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) : ptr(other.ptr), length(other.length) {
+        other.ptr = nullptr;
+        other.length = 0;
+    }
+    ~MappedFile() { close(); }
+
+    bool open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            std::cout << "ERROR::MAPPED_FILE::OPEN_FAILED " << path << std::endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                ptr = mapped;
+                length = (size_t)st.st_size;
+            }
+        }
+        ::close(fd);
+        if (!ptr) std::cout << "ERROR::MAPPED_FILE::MAP_FAILED " << path << std::endl;
+        return ptr != nullptr;
+    }
+
+    void close() {
+        if (ptr) munmap(ptr, length);
+        ptr = nullptr;
+        length = 0;
+    }
+
+    // hint that the whole file will be read front to back
+    void adviseSequential() const {
+        if (ptr) madvise(ptr, length, MADV_SEQUENTIAL);
+    }
+
+    const char* data() const { return (const char*)ptr; }
+    size_t size() const { return length; }
+    bool valid() const { return ptr != nullptr; }
+};
+
+#endif
\ No newline at end of file
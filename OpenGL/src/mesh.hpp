@@ -0,0 +1,180 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "models.hpp"
+#include "meshOptimizer.hpp"
+
+// CPU side indexed mesh in one of the createObj layouts
+struct MeshData {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    bool hasColor = false, hasTexture = false;
+
+    int stride() const { return vertexStride(hasColor, hasTexture); }
+    size_t vertexCount() const { return vertices.size() / stride(); }
+};
+
+// GPU side handle, consumed by glDrawElements with whatever index width the upload picked, move-only
+struct Mesh {
+    VertexArray VAO;
+    Buffer VBO, EBO;
+    GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    bool quantized = false;
+    VertexDecode decode; // uniforms a quantized mesh needs in fullVtxQuantized.glsl
+
+    void draw() const { glDrawElements(GL_TRIANGLES, indexCount, indexType, 0); }
+    void drawInstanced(GLsizei count) const { glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, 0, count); }
+};
+
+struct MeshStats {
+    size_t inputVertices = 0, uniqueVertices = 0, indexCount = 0;
+    size_t soupBytes = 0, indexedBytes = 0;
+};
+
+size_t indexSize(size_t vertexCount) { return vertexCount <= 65536 ? sizeof(uint16_t) : sizeof(uint32_t); }
+
+MeshStats meshStats(const MeshData& data, size_t inputVertices) {
+    MeshStats stats;
+    stats.inputVertices = inputVertices;
+    stats.uniqueVertices = data.vertexCount();
+    stats.indexCount = data.indices.size();
+    stats.soupBytes = inputVertices * data.stride() * sizeof(float);
+    stats.indexedBytes = data.vertices.size() * sizeof(float) + data.indices.size() * indexSize(data.vertexCount());
+    return stats;
+}
+
+void printMeshStats(const std::string& name, const MeshStats& stats) {
+    std::cout << name << ": " << stats.inputVertices << " -> " << stats.uniqueVertices << " vertices, "
+              << stats.indexCount << " indices, " << stats.soupBytes << " -> " << stats.indexedBytes << " bytes ("
+              << (stats.soupBytes ? 100.0 * (1.0 - (double)stats.indexedBytes / stats.soupBytes) : 0.0) << "% saved)" << std::endl;
+}
+
+// welds bit-identical vertices of triangle soups into a compact vertex array plus indices
+class MeshBuilder {
+private:
+    MeshData data;
+    std::vector<unsigned int> slots; // open addressing over data's vertices, ~0u marks an empty slot
+    size_t inputVertices = 0;
+
+    // -0.0 and 0.0 compare equal as floats, fold them so they weld as well
+    static uint32_t floatBits(float f) {
+        if (f == 0.0f) f = 0.0f;
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    }
+
+    uint32_t hashVertex(const float* v) const {
+        uint32_t h = 2166136261u;
+        for (int i = 0; i < data.stride(); i++) h = (h ^ floatBits(v[i])) * 16777619u;
+        return h ^ (h >> 15);
+    }
+
+    bool sameVertex(const float* a, const float* b) const {
+        for (int i = 0; i < data.stride(); i++)
+            if (floatBits(a[i]) != floatBits(b[i])) return false;
+        return true;
+    }
+
+    void rehash(size_t capacity) {
+        slots.assign(capacity, ~0u);
+        uint32_t mask = (uint32_t)capacity - 1;
+        for (unsigned int i = 0; i < data.vertexCount(); i++) {
+            uint32_t slot = hashVertex(&data.vertices[(size_t)i * data.stride()]) & mask;
+            while (slots[slot] != ~0u) slot = (slot + 1) & mask;
+            slots[slot] = i;
+        }
+    }
+public:
+    MeshBuilder(bool hasColor, bool hasTexture) {
+        data.hasColor = hasColor;
+        data.hasTexture = hasTexture;
+        slots.assign(64, ~0u);
+    }
+
+    unsigned int addVertex(const float* v) {
+        inputVertices++;
+        if ((data.vertexCount() + 1) * 2 > slots.size()) rehash(slots.size() * 2);
+        uint32_t mask = (uint32_t)slots.size() - 1;
+        uint32_t slot = hashVertex(v) & mask;
+        for (; slots[slot] != ~0u; slot = (slot + 1) & mask) {
+            if (sameVertex(&data.vertices[(size_t)slots[slot] * data.stride()], v)) return slots[slot];
+        }
+        unsigned int index = (unsigned int)data.vertexCount();
+        data.vertices.insert(data.vertices.end(), v, v + data.stride());
+        slots[slot] = index;
+        return index;
+    }
+
+    // vertices is a triangle soup of floatCount floats in this builder's layout
+    MeshBuilder& addTriangles(const float* vertices, size_t floatCount) {
+        size_t count = floatCount / data.stride();
+        data.indices.reserve(data.indices.size() + count);
+        for (size_t i = 0; i < count; i++) data.indices.push_back(addVertex(vertices + i * data.stride()));
+        return *this;
+    }
+
+    MeshStats stats() const { return meshStats(data, inputVertices); }
+    const MeshData& build() const { return data; }
+};
+
+// triangle order for the post-transform cache first, then vertex order to follow it
+void optimizeMesh(MeshData& data) {
+    optimizeVertexCache(data.indices, data.vertexCount());
+    optimizeVertexFetch(data.vertices, data.stride(), data.indices);
+}
+
+// uploads raw vertex and index blobs into a fresh VAO, both pointers only need to live for the call
+Mesh uploadMeshBuffers(const VertexLayout& layout, const void* vertices, size_t vertexBytes,
+                       const void* indices, GLsizei indexCount, GLenum indexType) {
+    Mesh mesh;
+    mesh.VAO.generate();
+    mesh.VAO.bind();
+    mesh.VBO.data(GL_ARRAY_BUFFER, vertexBytes, vertices, GL_STATIC_DRAW);
+    layout.apply();
+
+    size_t indexBytes = (size_t)indexCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+    mesh.EBO.data(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indices, GL_STATIC_DRAW);
+    mesh.indexCount = indexCount;
+    mesh.indexType = indexType;
+    return mesh;
+}
+
+// indices are narrowed to 16 bits whenever every vertex is addressable with them
+Mesh uploadMeshIndexed(const VertexLayout& layout, const void* vertices, size_t vertexBytes,
+                       const std::vector<unsigned int>& indices, size_t vertexCount) {
+    if (indexSize(vertexCount) == sizeof(uint16_t)) {
+        std::vector<uint16_t> narrow(indices.begin(), indices.end());
+        return uploadMeshBuffers(layout, vertices, vertexBytes, narrow.data(), (GLsizei)narrow.size(), GL_UNSIGNED_SHORT);
+    }
+    return uploadMeshBuffers(layout, vertices, vertexBytes, indices.data(), (GLsizei)indices.size(), GL_UNSIGNED_INT);
+}
+
+// uploads into a fresh VAO in the float createObj layout
+Mesh uploadMesh(const MeshData& data) {
+    return uploadMeshIndexed(objLayout(data.hasColor, data.hasTexture), data.vertices.data(), data.vertices.size() * sizeof(float),
+                             data.indices, data.vertexCount());
+}
+
+// indexed counterpart of createObj for any triangle soup in the createObj layouts
+Mesh createMesh(const float* vertices, size_t vtcSize, bool hasColor, bool hasTexture, MeshStats* stats = nullptr) {
+    MeshBuilder builder(hasColor, hasTexture);
+    builder.addTriangles(vertices, vtcSize / sizeof(float));
+    if (stats) *stats = builder.stats();
+    MeshData data = builder.build();
+    optimizeMesh(data);
+    return uploadMesh(data);
+}
+
+Mesh createIndexedCube() { return createMesh(defCube, sizeof(defCube), false, false); }
+Mesh createIndexedCubeWithNorm() { return createMesh(defCubeWithNorm, sizeof(defCubeWithNorm), true, false); }
+Mesh createIndexedCubeWithNormTex() { return createMesh(defCubeWithNormTex, sizeof(defCubeWithNormTex), true, true); }
+
+#endif
\ No newline at end of file
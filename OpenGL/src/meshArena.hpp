@@ -0,0 +1,306 @@
+#ifndef MESH_ARENA_H
+#define MESH_ARENA_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "glResource.hpp"
+#include "glState.hpp"
+#include "mesh.hpp"
+#include "vertexLayout.hpp"
+
+// best fit sub-allocator over [0, capacity) in whole vertices or indices. Free blocks are kept by offset so a
+// release coalesces with both neighbours, and by size so the smallest block that fits is one lookup away.
+class RangeAllocator {
+private:
+    std::map<uint32_t, uint32_t> byOffset; // offset -> size
+    std::multimap<uint32_t, uint32_t> bySize; // size -> offset
+    uint32_t capacity = 0, used = 0;
+
+    void addFree(uint32_t offset, uint32_t size) {
+        byOffset[offset] = size;
+        bySize.emplace(size, offset);
+    }
+
+    void removeFree(std::map<uint32_t, uint32_t>::iterator block) {
+        auto range = bySize.equal_range(block->second);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == block->first) {
+                bySize.erase(it);
+                break;
+            }
+        }
+        byOffset.erase(block);
+    }
+public:
+    static const uint32_t FAILED = ~0u;
+
+    void reset(uint32_t units) {
+        byOffset.clear();
+        bySize.clear();
+        capacity = units;
+        used = 0;
+        if (units) addFree(0, units);
+    }
+
+    uint32_t allocate(uint32_t size) {
+        if (size == 0) return FAILED;
+        auto fit = bySize.lower_bound(size);
+        if (fit == bySize.end()) return FAILED;
+        uint32_t offset = fit->second, blockSize = fit->first;
+        bySize.erase(fit);
+        byOffset.erase(offset);
+        if (blockSize > size) addFree(offset + size, blockSize - size);
+        used += size;
+        return offset;
+    }
+
+    void release(uint32_t offset, uint32_t size) {
+        used -= size;
+        auto next = byOffset.lower_bound(offset);
+        if (next != byOffset.end() && offset + size == next->first) {
+            size += next->second;
+            removeFree(next);
+        }
+        auto prev = byOffset.lower_bound(offset);
+        if (prev != byOffset.begin() && (--prev)->first + prev->second == offset) {
+            offset = prev->first;
+            size += prev->second;
+            removeFree(prev);
+        }
+        addFree(offset, size);
+    }
+
+    uint32_t usedUnits() const { return used; }
+    uint32_t freeUnits() const { return capacity - used; }
+    uint32_t capacityUnits() const { return capacity; }
+    size_t freeBlocks() const { return byOffset.size(); }
+    uint32_t largestFree() const { return bySize.empty() ? 0 : bySize.rbegin()->first; }
+};
+
+// where an arena mesh currently lives, defragment moves it so look it up again rather than keeping a copy
+struct ArenaRange {
+    uint32_t page;
+    GLint baseVertex;
+    GLuint firstIndex;
+    GLsizei indexCount;
+    uint32_t vertexCount;
+};
+
+struct ArenaStats {
+    size_t pages = 0, meshes = 0;
+    size_t vertexBytes = 0, usedVertexBytes = 0, indexBytes = 0, usedIndexBytes = 0;
+    size_t freeBlocks = 0;
+    double fragmentation = 0.0; // 1 - largest free block / all free space, worst over pages and both buffers
+};
+
+// shared vertex and index buffers per vertex layout, each page one VAO over a large VBO and a 32-bit EBO.
+// Meshes are sub-allocated ranges drawn with glDrawElementsBaseVertex, so everything in a page shares one VAO bind
+// and indices stay relative to the mesh. A mesh larger than a whole page gets a page of its own.
+class MeshArena {
+private:
+    struct Page {
+        VertexLayout layout;
+        VertexArray VAO;
+        Buffer VBO, EBO;
+        RangeAllocator vertices, indices;
+        size_t meshes = 0;
+    };
+    std::vector<Page> pages;
+    std::vector<ArenaRange> ranges;
+    std::vector<bool> live;
+    std::vector<uint32_t> freeIds;
+    uint32_t pageVertices, pageIndices;
+
+    static bool sameLayout(const VertexLayout& a, const VertexLayout& b) {
+        return a.stride == b.stride && a.count == b.count && !memcmp(a.attribs, b.attribs, a.count * sizeof(VertexAttrib));
+    }
+
+    // points the page VAO at its current buffers, after creation and after defragment swapped them
+    static void attach(Page& page) {
+        page.VAO.bind();
+        page.VBO.bind(GL_ARRAY_BUFFER);
+        page.layout.apply();
+        page.EBO.bind(GL_ELEMENT_ARRAY_BUFFER);
+    }
+
+    uint32_t addPage(const VertexLayout& layout, uint32_t vertexCount, uint32_t indexCount) {
+        pages.emplace_back();
+        Page& page = pages.back();
+        page.layout = layout;
+        vertexCount = std::max(vertexCount, pageVertices);
+        indexCount = std::max(indexCount, pageIndices);
+        page.vertices.reset(vertexCount);
+        page.indices.reset(indexCount);
+        page.VAO.generate();
+        page.VBO.data(GL_COPY_WRITE_BUFFER, (size_t)vertexCount * layout.stride, nullptr, GL_STATIC_DRAW);
+        page.EBO.data(GL_COPY_WRITE_BUFFER, (size_t)indexCount * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+        attach(page);
+        return (uint32_t)pages.size() - 1;
+    }
+
+    // the live meshes of a page packed to the front of fresh buffers, in their current order
+    void compact(uint32_t p) {
+        Page& page = pages[p];
+        std::vector<uint32_t> byVertex, byIndex;
+        for (uint32_t id = 0; id < ranges.size(); id++) {
+            if (live[id] && ranges[id].page == p) byVertex.push_back(id);
+        }
+        byIndex = byVertex;
+        std::sort(byVertex.begin(), byVertex.end(), [&](uint32_t a, uint32_t b) { return ranges[a].baseVertex < ranges[b].baseVertex; });
+        std::sort(byIndex.begin(), byIndex.end(), [&](uint32_t a, uint32_t b) { return ranges[a].firstIndex < ranges[b].firstIndex; });
+
+        // overlapping copies inside one buffer are an error, so pack into new ones and drop the old
+        Buffer vbo, ebo;
+        uint32_t vertexCount = page.vertices.capacityUnits(), indexCount = page.indices.capacityUnits(), stride = page.layout.stride;
+        vbo.data(GL_COPY_WRITE_BUFFER, (size_t)vertexCount * stride, nullptr, GL_STATIC_DRAW);
+        page.VBO.bind(GL_COPY_READ_BUFFER);
+        uint32_t packedVertices = 0;
+        for (uint32_t id : byVertex) {
+            ArenaRange& r = ranges[id];
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)r.baseVertex * stride, (GLintptr)packedVertices * stride,
+                                (GLsizeiptr)r.vertexCount * stride);
+            r.baseVertex = (GLint)packedVertices;
+            packedVertices += r.vertexCount;
+        }
+        ebo.data(GL_COPY_WRITE_BUFFER, (size_t)indexCount * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+        page.EBO.bind(GL_COPY_READ_BUFFER);
+        uint32_t packedIndices = 0;
+        for (uint32_t id : byIndex) {
+            ArenaRange& r = ranges[id];
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)r.firstIndex * sizeof(uint32_t),
+                                (GLintptr)packedIndices * sizeof(uint32_t), (GLsizeiptr)r.indexCount * sizeof(uint32_t));
+            r.firstIndex = packedIndices;
+            packedIndices += r.indexCount;
+        }
+        page.VBO = std::move(vbo);
+        page.EBO = std::move(ebo);
+        attach(page);
+        page.vertices.reset(vertexCount);
+        page.indices.reset(indexCount);
+        page.vertices.allocate(packedVertices);
+        page.indices.allocate(packedIndices);
+    }
+public:
+    // page sizes in vertices and indices, about 8 MB + 4 MB for the 32 byte createObj layout
+    MeshArena(uint32_t pageVertices = 1 << 18, uint32_t pageIndices = 1 << 20) : pageVertices(pageVertices), pageIndices(pageIndices) {}
+
+    // copies vertexCount vertices of layout and 32-bit indices relative to the mesh, returns the mesh id
+    uint32_t allocate(const VertexLayout& layout, const void* vertexData, uint32_t vertexCount, const uint32_t* indexData, uint32_t indexCount) {
+        if (!vertexCount || !indexCount) {
+            std::cerr << "ERROR::MESH_ARENA::EMPTY_MESH" << std::endl;
+            return ~0u;
+        }
+        uint32_t p = 0, vertexOffset = RangeAllocator::FAILED, indexOffset = RangeAllocator::FAILED;
+        for (; p < pages.size(); p++) {
+            Page& page = pages[p];
+            if (!sameLayout(page.layout, layout) || page.vertices.largestFree() < vertexCount || page.indices.largestFree() < indexCount) continue;
+            vertexOffset = page.vertices.allocate(vertexCount);
+            indexOffset = page.indices.allocate(indexCount);
+            break;
+        }
+        if (p == pages.size()) {
+            p = addPage(layout, vertexCount, indexCount);
+            vertexOffset = pages[p].vertices.allocate(vertexCount);
+            indexOffset = pages[p].indices.allocate(indexCount);
+        }
+        Page& page = pages[p];
+        page.VBO.subData(GL_COPY_WRITE_BUFFER, (size_t)vertexOffset * layout.stride, (size_t)vertexCount * layout.stride, vertexData);
+        page.EBO.subData(GL_COPY_WRITE_BUFFER, (size_t)indexOffset * sizeof(uint32_t), (size_t)indexCount * sizeof(uint32_t), indexData);
+        page.meshes++;
+
+        ArenaRange range = { p, (GLint)vertexOffset, indexOffset, (GLsizei)indexCount, vertexCount };
+        uint32_t id;
+        if (!freeIds.empty()) {
+            id = freeIds.back();
+            freeIds.pop_back();
+            ranges[id] = range;
+            live[id] = true;
+        } else {
+            id = (uint32_t)ranges.size();
+            ranges.push_back(range);
+            live.push_back(true);
+        }
+        return id;
+    }
+
+    // the ranges go back to their page, the id may be handed out again
+    void release(uint32_t id) {
+        if (id >= ranges.size() || !live[id]) return;
+        const ArenaRange& r = ranges[id];
+        Page& page = pages[r.page];
+        page.vertices.release((uint32_t)r.baseVertex, r.vertexCount);
+        page.indices.release(r.firstIndex, (uint32_t)r.indexCount);
+        page.meshes--;
+        live[id] = false;
+        freeIds.push_back(id);
+    }
+
+    // packs every page and drops the empty ones, mesh ids stay valid but their ranges move
+    void defragment() {
+        for (uint32_t p = 0; p < pages.size();) {
+            if (pages[p].meshes > 0) {
+                compact(p++);
+                continue;
+            }
+            pages.erase(pages.begin() + p);
+            for (uint32_t id = 0; id < ranges.size(); id++)
+                if (live[id] && ranges[id].page > p) ranges[id].page--;
+        }
+    }
+
+    const ArenaRange& range(uint32_t id) const { return ranges[id]; }
+
+    // one VAO per page, meshes drawn back to back from the same page skip the rebind
+    void bind(uint32_t id) const { pages[ranges[id].page].VAO.bind(); }
+
+    // expects bind(id) or another mesh of the same page bound
+    void draw(uint32_t id) const {
+        const ArenaRange& r = ranges[id];
+        glDrawElementsBaseVertex(GL_TRIANGLES, r.indexCount, GL_UNSIGNED_INT, (void*)(uintptr_t)(r.firstIndex * sizeof(uint32_t)), r.baseVertex);
+    }
+
+    ArenaStats stats() const {
+        ArenaStats s;
+        s.pages = pages.size();
+        for (const Page& page : pages) {
+            s.meshes += page.meshes;
+            s.vertexBytes += (size_t)page.vertices.capacityUnits() * page.layout.stride;
+            s.usedVertexBytes += (size_t)page.vertices.usedUnits() * page.layout.stride;
+            s.indexBytes += (size_t)page.indices.capacityUnits() * sizeof(uint32_t);
+            s.usedIndexBytes += (size_t)page.indices.usedUnits() * sizeof(uint32_t);
+            s.freeBlocks += page.vertices.freeBlocks() + page.indices.freeBlocks();
+            for (const RangeAllocator* a : { &page.vertices, &page.indices })
+                if (a->freeUnits()) s.fragmentation = std::max(s.fragmentation, 1.0 - (double)a->largestFree() / a->freeUnits());
+        }
+        return s;
+    }
+};
+
+void printArenaStats(const std::string& label, const ArenaStats& s) {
+    std::cout << label << ": " << s.meshes << " meshes in " << s.pages << " pages, vertices " << s.usedVertexBytes / 1024 << "/"
+              << s.vertexBytes / 1024 << " KB, indices " << s.usedIndexBytes / 1024 << "/" << s.indexBytes / 1024 << " KB, "
+              << s.freeBlocks << " free blocks, " << s.fragmentation * 100.0 << "% fragmented" << std::endl;
+}
+
+// arena counterpart of uploadMesh, indices are kept at 32 bits
+uint32_t uploadArenaMesh(MeshArena& arena, const MeshData& data) {
+    return arena.allocate(objLayout(data.hasColor, data.hasTexture), data.vertices.data(), (uint32_t)data.vertexCount(),
+                          data.indices.data(), (uint32_t)data.indices.size());
+}
+
+// arena counterpart of createMesh for any triangle soup in the createObj layouts
+uint32_t createArenaMesh(MeshArena& arena, const float* vertices, size_t vtcSize, bool hasColor, bool hasTexture) {
+    MeshBuilder builder(hasColor, hasTexture);
+    builder.addTriangles(vertices, vtcSize / sizeof(float));
+    MeshData data = builder.build();
+    optimizeMesh(data);
+    return uploadArenaMesh(arena, data);
+}
+
+#endif
\ No newline at end of file
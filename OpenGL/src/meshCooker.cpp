@@ -0,0 +1,74 @@
+// offline tool, built on its own next to glad.c rather than with main.cpp:
+//   meshCooker <input.obj | cube | cubeNorm | cubeNormTex | sphere> <output.mesh> [--no-optimize] [--quantize]
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "meshFile.hpp"
+#include "objLoader.hpp"
+
+// the models.hpp arrays cookable by name
+bool builtinMesh(const std::string& name, MeshData& data, MeshStats& stats) {
+    std::vector<float> sphere;
+    const float* vertices = nullptr;
+    size_t bytes = 0;
+    bool hasColor = true, hasTexture = false;
+    if (name == "cube") {
+        vertices = defCube;
+        bytes = sizeof(defCube);
+        hasColor = false;
+    } else if (name == "cubeNorm") {
+        vertices = defCubeWithNorm;
+        bytes = sizeof(defCubeWithNorm);
+    } else if (name == "cubeNormTex") {
+        vertices = defCubeWithNormTex;
+        bytes = sizeof(defCubeWithNormTex);
+        hasTexture = true;
+    } else if (name == "sphere") {
+        sphere = defSphereWithNormTex(32, 64);
+        vertices = sphere.data();
+        bytes = sphere.size() * sizeof(float);
+        hasTexture = true;
+    } else return false;
+    MeshBuilder builder(hasColor, hasTexture);
+    builder.addTriangles(vertices, bytes / sizeof(float));
+    stats = builder.stats();
+    data = builder.build();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <input.obj | cube | cubeNorm | cubeNormTex | sphere> <output.mesh> [--no-optimize] [--quantize]" << std::endl;
+        return 1;
+    }
+    const char* input = argv[1];
+    const char* output = argv[2];
+    bool optimize = true, quantize = false;
+    for (int i = 3; i < argc; i++) {
+        if (!strcmp(argv[i], "--no-optimize")) optimize = false;
+        else if (!strcmp(argv[i], "--quantize")) quantize = true;
+    }
+
+    MeshData data;
+    MeshStats stats;
+    if (builtinMesh(input, data, stats)) printMeshStats(input, stats);
+    else {
+        ObjStats objStats;
+        if (!loadObj(input, data, &objStats)) return 1;
+        std::cout << input << ": " << objStats.triangles << " triangles, " << objStats.vertices << " welded vertices" << std::endl;
+    }
+    if (optimize) optimizeMesh(data);
+    if (!writeMeshFile(output, data, quantize)) return 1;
+
+    size_t stride = data.stride() * sizeof(float);
+    if (quantize) {
+        QuantizedVertices q = quantizeVertices(data);
+        printQuantizationError(output, measureQuantization(data, q));
+        stride = q.layout.stride;
+    }
+    VertexCacheStats cache = analyzeVertexCache(data.indices, data.vertexCount());
+    std::cout << "wrote " << output << ": " << data.vertexCount() << " vertices, " << data.indices.size() << " indices, "
+              << stride << " byte stride, ACMR " << cache.acmr << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+#include "mappedFile.hpp"
+#include "mesh.hpp"
+#include "quantize.hpp"
+#include "vertexLayout.hpp"
+
+// cooked meshes: a fixed header followed by the vertex and index blobs exactly as glBufferData wants them,
+// little endian and aligned so the mapped file can be handed to GL without touching a single byte
+const uint32_t MESH_FILE_MAGIC = 0x4853454d; // "MESH"
+const uint32_t MESH_FILE_VERSION = 2;
+const uint32_t MESH_FILE_ALIGNMENT = 64;
+const uint32_t MESH_FILE_QUANTIZED = 1; // flags bit, the blob is in the quantizeVertices layout
+
+struct MeshFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32_t flags;
+    VertexLayout layout;
+    uint64_t vertexOffset, vertexBytes;
+    uint64_t indexOffset, indexBytes;
+    float boundsMin[3], boundsMax[3]; // object space AABB of the positions at location 0
+    VertexDecode decode;
+};
+
+static_assert(std::is_trivially_copyable<MeshFileHeader>::value, "MeshFileHeader is read straight out of the mapping");
+static_assert(sizeof(MeshFileHeader) == 208, "MeshFileHeader layout changed, bump MESH_FILE_VERSION");
+
+uint64_t meshFileAlign(uint64_t offset) { return (offset + MESH_FILE_ALIGNMENT - 1) & ~(uint64_t)(MESH_FILE_ALIGNMENT - 1); }
+
+// positions are the first three floats of every createObj layout
+void meshBounds(const MeshData& data, float boundsMin[3], float boundsMax[3]) {
+    for (int c = 0; c < 3; c++) {
+        boundsMin[c] = data.vertexCount() ? data.vertices[c] : 0.0f;
+        boundsMax[c] = boundsMin[c];
+    }
+    for (size_t v = 0; v < data.vertexCount(); v++) {
+        const float* pos = &data.vertices[v * data.stride()];
+        for (int c = 0; c < 3; c++) {
+            boundsMin[c] = std::min(boundsMin[c], pos[c]);
+            boundsMax[c] = std::max(boundsMax[c], pos[c]);
+        }
+    }
+}
+
+// blobs are already laid out for upload, data is written as is so run optimizeMesh first when wanted
+bool writeMeshFile(const char* path, const MeshData& data, bool quantize = false) {
+    MeshFileHeader header = {};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertexCount = (uint32_t)data.vertexCount();
+    header.indexCount = (uint32_t)data.indices.size();
+    header.layout = objLayout(data.hasColor, data.hasTexture);
+    meshBounds(data, header.boundsMin, header.boundsMax);
+
+    QuantizedVertices q;
+    const void* vertices = data.vertices.data();
+    header.vertexBytes = data.vertices.size() * sizeof(float);
+    if (quantize) {
+        q = quantizeVertices(data);
+        vertices = q.bytes.data();
+        header.vertexBytes = q.bytes.size();
+        header.layout = q.layout;
+        header.decode = q.decode;
+        header.flags |= MESH_FILE_QUANTIZED;
+    }
+
+    std::vector<uint16_t> narrow;
+    const void* indices = data.indices.data();
+    if (indexSize(data.vertexCount()) == sizeof(uint16_t)) {
+        narrow.assign(data.indices.begin(), data.indices.end());
+        indices = narrow.data();
+        header.indexType = GL_UNSIGNED_SHORT;
+        header.indexBytes = narrow.size() * sizeof(uint16_t);
+    } else {
+        header.indexType = GL_UNSIGNED_INT;
+        header.indexBytes = data.indices.size() * sizeof(uint32_t);
+    }
+    header.vertexOffset = meshFileAlign(sizeof(MeshFileHeader));
+    header.indexOffset = meshFileAlign(header.vertexOffset + header.vertexBytes);
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        std::cout << "ERROR::MESH_FILE::OPEN_FAILED " << path << std::endl;
+        return false;
+    }
+    static const char zeros[MESH_FILE_ALIGNMENT] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(zeros, 1, header.vertexOffset - sizeof(header), file) == header.vertexOffset - sizeof(header);
+    ok = ok && fwrite(vertices, 1, header.vertexBytes, file) == header.vertexBytes;
+    ok = ok && fwrite(zeros, 1, header.indexOffset - header.vertexOffset - header.vertexBytes, file) == header.indexOffset - header.vertexOffset - header.vertexBytes;
+    ok = ok && fwrite(indices, 1, header.indexBytes, file) == header.indexBytes;
+    ok = fclose(file) == 0 && ok;
+    if (!ok) std::cout << "ERROR::MESH_FILE::WRITE_FAILED " << path << std::endl;
+    return ok;
+}
+
+// checks everything the loader is about to trust, the blobs themselves are not touched
+bool validMeshFile(const MappedFile& file, const char* path) {
+    if (file.size() < sizeof(MeshFileHeader)) {
+        std::cout << "ERROR::MESH_FILE::TRUNCATED " << path << std::endl;
+        return false;
+    }
+    const MeshFileHeader& header = *(const MeshFileHeader*)file.data();
+    if (header.magic != MESH_FILE_MAGIC) {
+        std::cout << "ERROR::MESH_FILE::BAD_MAGIC " << path << std::endl;
+        return false;
+    }
+    if (header.version != MESH_FILE_VERSION) {
+        std::cout << "ERROR::MESH_FILE::VERSION_MISMATCH " << path << " is v" << header.version
+                  << ", expected v" << MESH_FILE_VERSION << ", re-cook it" << std::endl;
+        return false;
+    }
+    size_t indexWidth = header.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    bool ok = header.layout.count <= (uint32_t)VertexLayout::MAX_ATTRIBS && header.layout.stride > 0
+        && (header.indexType == GL_UNSIGNED_SHORT || header.indexType == GL_UNSIGNED_INT)
+        && header.vertexBytes == (uint64_t)header.vertexCount * header.layout.stride
+        && header.indexBytes == (uint64_t)header.indexCount * indexWidth
+        && header.vertexOffset % MESH_FILE_ALIGNMENT == 0 && header.indexOffset % MESH_FILE_ALIGNMENT == 0
+        && header.vertexOffset <= file.size() && header.vertexBytes <= file.size() - header.vertexOffset
+        && header.indexOffset <= file.size() && header.indexBytes <= file.size() - header.indexOffset;
+    // every attribute has to start inside its vertex
+    for (uint32_t i = 0; ok && i < header.layout.count; i++)
+        ok = header.layout.attribs[i].offset < header.layout.stride;
+    if (!ok) std::cout << "ERROR::MESH_FILE::CORRUPT_HEADER " << path << std::endl;
+    return ok;
+}
+
+// maps a cooked mesh and uploads straight out of the mapping, no parsing and no intermediate copies
+bool loadMeshFile(const char* path, Mesh& mesh, MeshFileHeader* info = nullptr) {
+    MappedFile file(path);
+    if (!file.valid() || !validMeshFile(file, path)) return false;
+    const MeshFileHeader& header = *(const MeshFileHeader*)file.data();
+    file.adviseSequential();
+    mesh = uploadMeshBuffers(header.layout, file.data() + header.vertexOffset, header.vertexBytes,
+                             file.data() + header.indexOffset, (GLsizei)header.indexCount, header.indexType);
+    mesh.quantized = (header.flags & MESH_FILE_QUANTIZED) != 0;
+    mesh.decode = header.decode;
+    if (info) *info = header;
+    return true;
+}
+
+#endif
\ No newline at end of file
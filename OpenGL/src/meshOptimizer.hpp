@@ -0,0 +1,153 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cmath>
+#include <vector>
+
+// size of the LRU cache Forsyth's scoring models, larger than any real post-transform cache on purpose
+const int FORSYTH_CACHE_SIZE = 32;
+
+struct VertexCacheStats {
+    float acmr = 0.0f; // transformed vertices per triangle, 0.5 is the ideal for large regular meshes
+    float atvr = 0.0f; // transformed vertices per referenced vertex, 1.0 is the ideal
+    size_t transforms = 0;
+};
+
+// simulates a FIFO post-transform cache of cacheSize entries over a triangle list
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = 16) {
+    VertexCacheStats stats;
+    if (indices.empty()) return stats;
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    unsigned int time = cacheSize + 1;
+    size_t unique = 0;
+    for (unsigned int index : indices) {
+        if (time - timestamps[index] > cacheSize) {
+            timestamps[index] = time++;
+            stats.transforms++;
+        }
+        if (!referenced[index]) {
+            referenced[index] = true;
+            unique++;
+        }
+    }
+    stats.acmr = (float)stats.transforms / (indices.size() / 3);
+    stats.atvr = (float)stats.transforms / unique;
+    return stats;
+}
+
+float forsythVertexScore(int cachePos, unsigned int remaining) {
+    if (remaining == 0) return -1.0f;
+    float score = 0.0f;
+    if (cachePos >= 0) {
+        // the three vertices of the last triangle get a fixed score so it is not simply repeated
+        if (cachePos < 3) score = 0.75f;
+        else score = std::pow(1.0f - (cachePos - 3) * (1.0f / (FORSYTH_CACHE_SIZE - 3)), 1.5f);
+    }
+    // boost vertices with few triangles left so they get finished instead of stranded
+    return score + 2.0f * std::pow((float)remaining, -0.5f);
+}
+
+// Tom Forsyth's linear-speed vertex cache optimisation, reorders triangles in place
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) {
+    size_t triCount = indices.size() / 3;
+    if (triCount == 0) return;
+
+    // triangles adjacent to each vertex, the live ones are kept at the front of each range
+    std::vector<unsigned int> remaining(vertexCount, 0), offsets(vertexCount + 1, 0), adjacency(triCount * 3);
+    for (size_t i = 0; i < triCount * 3; i++) remaining[indices[i]]++;
+    for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triCount * 3; i++) adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+    std::vector<int> cachePos(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    std::vector<bool> emitted(triCount, false);
+    for (size_t v = 0; v < vertexCount; v++) vertexScore[v] = forsythVertexScore(-1, remaining[v]);
+    int best = 0;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triCount; t++) {
+        float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        if (score > bestScore) {
+            bestScore = score;
+            best = (int)t;
+        }
+    }
+
+    std::vector<unsigned int> output;
+    output.reserve(triCount * 3);
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+    size_t scan = 0;
+    for (size_t n = 0; n < triCount; n++) {
+        // nothing in the cache touches a live triangle, restart from the next one in input order
+        if (best < 0) {
+            while (emitted[scan]) scan++;
+            best = (int)scan;
+        }
+        unsigned int t = (unsigned int)best;
+        emitted[t] = true;
+        const unsigned int tri[3] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+        output.insert(output.end(), tri, tri + 3);
+
+        nextCache.clear();
+        for (unsigned int v : tri) {
+            unsigned int* adj = &adjacency[offsets[v]];
+            for (unsigned int i = 0; i < remaining[v]; i++) {
+                if (adj[i] == t) {
+                    adj[i] = adj[remaining[v] - 1];
+                    remaining[v]--;
+                    break;
+                }
+            }
+            bool seen = false;
+            for (unsigned int c : nextCache) seen |= c == v;
+            if (!seen) nextCache.push_back(v);
+        }
+        for (unsigned int v : cache) {
+            if (v != tri[0] && v != tri[1] && v != tri[2]) nextCache.push_back(v);
+        }
+
+        // rescore everything that entered, moved or fell out of the cache, then the triangles around them
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            unsigned int v = nextCache[i];
+            cachePos[v] = i < (size_t)FORSYTH_CACHE_SIZE ? (int)i : -1;
+            vertexScore[v] = forsythVertexScore(cachePos[v], remaining[v]);
+        }
+        best = -1;
+        bestScore = -1.0f;
+        for (unsigned int v : nextCache) {
+            for (unsigned int i = 0; i < remaining[v]; i++) {
+                unsigned int adj = adjacency[offsets[v] + i];
+                float score = vertexScore[indices[adj * 3]] + vertexScore[indices[adj * 3 + 1]] + vertexScore[indices[adj * 3 + 2]];
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = (int)adj;
+                }
+            }
+        }
+        if (nextCache.size() > (size_t)FORSYTH_CACHE_SIZE) nextCache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(nextCache);
+    }
+    indices.swap(output);
+}
+
+// renumbers vertices in first use order so fetches walk the vertex buffer linearly, unreferenced vertices are dropped
+void optimizeVertexFetch(std::vector<float>& vertices, int stride, std::vector<unsigned int>& indices) {
+    size_t vertexCount = vertices.size() / stride;
+    std::vector<unsigned int> remap(vertexCount, ~0u);
+    std::vector<float> reordered;
+    reordered.reserve(vertices.size());
+    unsigned int next = 0;
+    for (unsigned int& index : indices) {
+        if (remap[index] == ~0u) {
+            remap[index] = next++;
+            reordered.insert(reordered.end(), vertices.begin() + (size_t)index * stride, vertices.begin() + (size_t)(index + 1) * stride);
+        }
+        index = remap[index];
+    }
+    vertices.swap(reordered);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,426 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "jobs.hpp"
+#include "simd.hpp"
+
+// levels of a full chain down to 1x1
+int mipLevelCount(int width, int height) {
+    int levels = 1;
+    for (; width > 1 || height > 1; levels++) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return levels;
+}
+
+// bytes of every level below level 0, what generateMipChain writes
+size_t mipChainBytes(int width, int height, int components) {
+    size_t bytes = 0;
+    for (int level = 1, count = mipLevelCount(width, height); level < count; level++) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        bytes += (size_t)width * height * components;
+    }
+    return bytes;
+}
+
+// Box averages 2x2 texels, odd sizes drop their last column or row. Kaiser is a 6 tap windowed sinc per axis,
+// sharper on the way down and less prone to aliasing on fine detail, at about three times the cost.
+enum class MipFilter { Box, Kaiser };
+
+struct MipOptions {
+    MipFilter filter = MipFilter::Box;
+    bool srgb = false; // colour is filtered in linear space and stored back as sRGB, alpha is linear either way
+    bool normalMap = false; // RGB is a unit vector, renormalized on every level instead of shrinking towards grey
+};
+
+enum class MipPath { Scalar, SSE, AVX2 };
+
+const char* mipPathName(MipPath path) {
+    static const char* names[] = { "scalar", "SSE", "AVX2" };
+    return names[(int)path];
+}
+
+bool mipPathSupported(MipPath path) {
+    switch (path) {
+    case MipPath::Scalar: return true;
+#ifdef SIMD_SSE
+    case MipPath::SSE: return true;
+#endif
+#ifdef SIMD_AVX2
+    case MipPath::AVX2: return simdHasAVX2();
+#endif
+    default: return false;
+    }
+}
+
+MipPath bestMipPath() {
+    for (MipPath path : { MipPath::AVX2, MipPath::SSE })
+        if (mipPathSupported(path)) return path;
+    return MipPath::Scalar;
+}
+
+// 8 bit sRGB to linear, and linear quantized to 14 bits back to 8 bit sRGB, fine enough for the steep end near black
+struct SrgbTables {
+    static const int LINEAR_STEPS = 1 << 14;
+    float toLinear[256];
+    uint8_t fromLinear[LINEAR_STEPS];
+
+    SrgbTables() {
+        for (int i = 0; i < 256; i++) {
+            float s = i / 255.0f;
+            toLinear[i] = s <= 0.04045f ? s / 12.92f : std::pow((s + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < LINEAR_STEPS; i++) {
+            float l = i / (float)(LINEAR_STEPS - 1);
+            float s = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            fromLinear[i] = (uint8_t)(s * 255.0f + 0.5f);
+        }
+    }
+};
+
+const SrgbTables& srgbTables() {
+    static const SrgbTables tables;
+    return tables;
+}
+
+// weights of the Kaiser filter (alpha 4, radius 3) at source offsets -2.5 to 2.5 around an output texel's centre
+struct KaiserTaps {
+    float w[6];
+
+    KaiserTaps() {
+        auto bessel0 = [](float x) {
+            float sum = 1.0f, term = 1.0f;
+            for (int k = 1; k < 16; k++) {
+                term *= (x / (2.0f * k)) * (x / (2.0f * k));
+                sum += term;
+            }
+            return sum;
+        };
+        const float alpha = 4.0f, radius = 3.0f, pi = 3.14159265f;
+        float total = 0.0f;
+        for (int k = 0; k < 6; k++) {
+            float x = k - 2.5f, t = x / 2.0f; // half the source rate
+            float sinc = std::sin(pi * t) / (pi * t);
+            w[k] = sinc * bessel0(alpha * std::sqrt(1.0f - (x / radius) * (x / radius))) / bessel0(alpha);
+            total += w[k];
+        }
+        for (float& weight : w) weight /= total;
+    }
+};
+
+const KaiserTaps& kaiserTaps() {
+    static const KaiserTaps taps;
+    return taps;
+}
+
+// rows below are 4 floats a texel whatever the source had, missing channels are 0 and missing alpha 1.
+// The first three channels are colour (or the normal), the fourth alpha.
+
+void mipLoadRowScalar(const uint8_t* in, int width, int components, const MipOptions& options, float* out) {
+    const float* toLinear = srgbTables().toLinear;
+    for (int x = 0; x < width; x++, in += components, out += 4)
+        for (int c = 0; c < 4; c++) {
+            if (c >= components) out[c] = c == 3 ? 1.0f : 0.0f;
+            else if (c == 3) out[c] = in[c] * (1.0f / 255.0f);
+            else if (options.normalMap) out[c] = in[c] * (2.0f / 255.0f) + -1.0f;
+            else if (options.srgb) out[c] = toLinear[in[c]];
+            else out[c] = in[c] * (1.0f / 255.0f);
+        }
+}
+
+void mipStoreRowScalar(const float* in, int width, int components, const MipOptions& options, uint8_t* out) {
+    const uint8_t* fromLinear = srgbTables().fromLinear;
+    for (int x = 0; x < width; x++, in += 4, out += components)
+        for (int c = 0; c < components; c++) {
+            float v;
+            if (c == 3) v = in[c] * 255.0f;
+            else if (options.normalMap) v = in[c] * 127.5f + 127.5f;
+            else if (options.srgb) {
+                out[c] = fromLinear[(int)(std::min(std::max(in[c], 0.0f), 1.0f) * (SrgbTables::LINEAR_STEPS - 1) + 0.5f)];
+                continue;
+            } else v = in[c] * 255.0f;
+            out[c] = (uint8_t)(std::min(std::max(v, 0.0f), 255.0f) + 0.5f);
+        }
+}
+
+void mipBoxRowScalar(const float* a, const float* b, int width, int outWidth, float* out) {
+    for (int x = 0; x < outWidth; x++) {
+        int x0 = std::min(2 * x, width - 1) * 4, x1 = std::min(2 * x + 1, width - 1) * 4;
+        for (int c = 0; c < 4; c++) out[x * 4 + c] = ((a[x0 + c] + a[x1 + c]) + (b[x0 + c] + b[x1 + c])) * 0.25f;
+    }
+}
+
+void mipKaiserRowScalar(const float* in, int width, int outWidth, const float* w, float* out) {
+    for (int x = 0; x < outWidth; x++)
+        for (int c = 0; c < 4; c++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 6; k++) sum = sum + w[k] * in[std::min(std::max(2 * x - 2 + k, 0), width - 1) * 4 + c];
+            out[x * 4 + c] = sum;
+        }
+}
+
+void mipKaiserColumnScalar(const float* const* rows, int outWidth, const float* w, float* out) {
+    for (int i = 0; i < outWidth * 4; i++) {
+        float sum = 0.0f;
+        for (int k = 0; k < 6; k++) sum = sum + w[k] * rows[k][i];
+        out[i] = sum;
+    }
+}
+
+void mipNormalizeRowScalar(float* row, int width) {
+    for (int x = 0; x < width; x++, row += 4) {
+        float length = std::sqrt((row[0] * row[0] + row[1] * row[1]) + (row[2] * row[2] + 0.0f));
+        float scale = 1.0f / std::max(length, 1e-8f);
+        for (int c = 0; c < 3; c++) row[c] *= scale;
+    }
+}
+
+#ifdef SIMD_SSE
+// RGBA only without sRGB, the other layouts go through the scalar loops
+void mipLoadRowSSE(const uint8_t* in, int width, int components, const MipOptions& options, float* out) {
+    if (components != 4 || options.srgb) return mipLoadRowScalar(in, width, components, options, out);
+    __m128 scale = options.normalMap ? _mm_setr_ps(2.0f / 255.0f, 2.0f / 255.0f, 2.0f / 255.0f, 1.0f / 255.0f) : _mm_set1_ps(1.0f / 255.0f);
+    __m128 bias = options.normalMap ? _mm_setr_ps(-1.0f, -1.0f, -1.0f, 0.0f) : _mm_setzero_ps();
+    __m128i zero = _mm_setzero_si128();
+    for (int x = 0; x < width; x++) {
+        int32_t texel;
+        memcpy(&texel, in + x * 4, 4);
+        __m128i wide = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(texel), zero), zero);
+        _mm_storeu_ps(out + x * 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(wide), scale), bias));
+    }
+}
+
+void mipStoreRowSSE(const float* in, int width, int components, const MipOptions& options, uint8_t* out) {
+    if (components != 4 || options.srgb) return mipStoreRowScalar(in, width, components, options, out);
+    __m128 scale = options.normalMap ? _mm_setr_ps(127.5f, 127.5f, 127.5f, 255.0f) : _mm_set1_ps(255.0f);
+    __m128 bias = options.normalMap ? _mm_setr_ps(127.5f, 127.5f, 127.5f, 0.0f) : _mm_setzero_ps();
+    __m128 lo = _mm_setzero_ps(), hi = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+    for (int x = 0; x < width; x++) {
+        __m128 v = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + x * 4), scale), bias), lo), hi);
+        __m128i i = _mm_cvttps_epi32(_mm_add_ps(v, half));
+        i = _mm_packus_epi16(_mm_packs_epi32(i, i), i);
+        int32_t texel = _mm_cvtsi128_si32(i);
+        memcpy(out + x * 4, &texel, 4);
+    }
+}
+
+void mipBoxRowSSE(const float* a, const float* b, int width, int outWidth, float* out) {
+    __m128 quarter = _mm_set1_ps(0.25f);
+    for (int x = 0; x < outWidth; x++) {
+        int x0 = std::min(2 * x, width - 1) * 4, x1 = std::min(2 * x + 1, width - 1) * 4;
+        __m128 top = _mm_add_ps(_mm_loadu_ps(a + x0), _mm_loadu_ps(a + x1));
+        __m128 bottom = _mm_add_ps(_mm_loadu_ps(b + x0), _mm_loadu_ps(b + x1));
+        _mm_storeu_ps(out + x * 4, _mm_mul_ps(_mm_add_ps(top, bottom), quarter));
+    }
+}
+
+void mipKaiserRowSSE(const float* in, int width, int outWidth, const float* w, float* out) {
+    __m128 weights[6];
+    for (int k = 0; k < 6; k++) weights[k] = _mm_set1_ps(w[k]);
+    for (int x = 0; x < outWidth; x++) {
+        __m128 sum = _mm_setzero_ps();
+        for (int k = 0; k < 6; k++) sum = _mm_add_ps(sum, _mm_mul_ps(weights[k], _mm_loadu_ps(in + std::min(std::max(2 * x - 2 + k, 0), width - 1) * 4)));
+        _mm_storeu_ps(out + x * 4, sum);
+    }
+}
+
+void mipKaiserColumnSSE(const float* const* rows, int outWidth, const float* w, float* out) {
+    __m128 weights[6];
+    for (int k = 0; k < 6; k++) weights[k] = _mm_set1_ps(w[k]);
+    for (int i = 0; i < outWidth * 4; i += 4) {
+        __m128 sum = _mm_setzero_ps();
+        for (int k = 0; k < 6; k++) sum = _mm_add_ps(sum, _mm_mul_ps(weights[k], _mm_loadu_ps(rows[k] + i)));
+        _mm_storeu_ps(out + i, sum);
+    }
+}
+
+// one texel a register, the dot product of xyz lands in every lane after two shuffles
+void mipNormalizeRowSSE(float* row, int width) {
+    __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)), tiny = _mm_set1_ps(1e-8f), one = _mm_set1_ps(1.0f);
+    for (int x = 0; x < width; x++, row += 4) {
+        __m128 v = _mm_loadu_ps(row);
+        __m128 squares = _mm_and_ps(_mm_mul_ps(v, v), xyz);
+        __m128 sum = _mm_add_ps(squares, _mm_shuffle_ps(squares, squares, _MM_SHUFFLE(2, 3, 0, 1)));
+        sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        __m128 scale = _mm_div_ps(one, _mm_max_ps(_mm_sqrt_ps(sum), tiny));
+        _mm_storeu_ps(row, _mm_or_ps(_mm_and_ps(_mm_mul_ps(v, scale), xyz), _mm_andnot_ps(xyz, v)));
+    }
+}
+#endif
+
+#ifdef SIMD_AVX2
+// two output texels a register, the halves are the same SSE math so every path gives the same bits
+__attribute__((target("avx2"))) void mipBoxRowAVX2(const float* a, const float* b, int width, int outWidth, float* out) {
+    __m256 quarter = _mm256_set1_ps(0.25f);
+    int x = 0;
+    for (; 2 * x + 3 < width && x + 1 < outWidth; x += 2) {
+        // texels 2x..2x+3 of both rows, (0 1) and (2 3) pair up across the 128 bit halves
+        __m256 a01 = _mm256_loadu_ps(a + 8 * x), a23 = _mm256_loadu_ps(a + 8 * x + 8);
+        __m256 b01 = _mm256_loadu_ps(b + 8 * x), b23 = _mm256_loadu_ps(b + 8 * x + 8);
+        __m256 top = _mm256_add_ps(_mm256_permute2f128_ps(a01, a23, 0x20), _mm256_permute2f128_ps(a01, a23, 0x31));
+        __m256 bottom = _mm256_add_ps(_mm256_permute2f128_ps(b01, b23, 0x20), _mm256_permute2f128_ps(b01, b23, 0x31));
+        _mm256_storeu_ps(out + 4 * x, _mm256_mul_ps(_mm256_add_ps(top, bottom), quarter));
+    }
+    mipBoxRowSSE(a + 8 * x, b + 8 * x, width - 2 * x, outWidth - x, out + 4 * x);
+}
+
+__attribute__((target("avx2"))) void mipKaiserRowAVX2(const float* in, int width, int outWidth, const float* w, float* out) {
+    __m256 weights[6];
+    for (int k = 0; k < 6; k++) weights[k] = _mm256_set1_ps(w[k]);
+    int x = 0;
+    for (; x + 1 < outWidth; x += 2) {
+        __m256 sum = _mm256_setzero_ps();
+        for (int k = 0; k < 6; k++) {
+            const float* first = in + std::min(std::max(2 * x - 2 + k, 0), width - 1) * 4;
+            const float* second = in + std::min(std::max(2 * x + k, 0), width - 1) * 4;
+            __m256 texels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(first)), _mm_loadu_ps(second), 1);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(weights[k], texels));
+        }
+        _mm256_storeu_ps(out + x * 4, sum);
+    }
+    if (x < outWidth) {
+        __m128 sum = _mm_setzero_ps();
+        for (int k = 0; k < 6; k++)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(in + std::min(std::max(2 * x - 2 + k, 0), width - 1) * 4)));
+        _mm_storeu_ps(out + x * 4, sum);
+    }
+}
+
+__attribute__((target("avx2"))) void mipKaiserColumnAVX2(const float* const* rows, int outWidth, const float* w, float* out) {
+    __m256 weights[6];
+    for (int k = 0; k < 6; k++) weights[k] = _mm256_set1_ps(w[k]);
+    int i = 0;
+    for (; i + 8 <= outWidth * 4; i += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (int k = 0; k < 6; k++) sum = _mm256_add_ps(sum, _mm256_mul_ps(weights[k], _mm256_loadu_ps(rows[k] + i)));
+        _mm256_storeu_ps(out + i, sum);
+    }
+    if (i < outWidth * 4) {
+        const float* tail[6];
+        for (int k = 0; k < 6; k++) tail[k] = rows[k] + i;
+        mipKaiserColumnSSE(tail, 1, w, out + i);
+    }
+}
+#endif
+
+void mipLoadRow(MipPath path, const uint8_t* in, int width, int components, const MipOptions& options, float* out) {
+#ifdef SIMD_SSE
+    if (path != MipPath::Scalar) return mipLoadRowSSE(in, width, components, options, out);
+#endif
+    mipLoadRowScalar(in, width, components, options, out);
+}
+
+void mipStoreRow(MipPath path, const float* in, int width, int components, const MipOptions& options, uint8_t* out) {
+#ifdef SIMD_SSE
+    if (path != MipPath::Scalar) return mipStoreRowSSE(in, width, components, options, out);
+#endif
+    mipStoreRowScalar(in, width, components, options, out);
+}
+
+void mipBoxRow(MipPath path, const float* a, const float* b, int width, int outWidth, float* out) {
+    switch (path) {
+#ifdef SIMD_AVX2
+    case MipPath::AVX2: return mipBoxRowAVX2(a, b, width, outWidth, out);
+#endif
+#ifdef SIMD_SSE
+    case MipPath::SSE: return mipBoxRowSSE(a, b, width, outWidth, out);
+#endif
+    default: return mipBoxRowScalar(a, b, width, outWidth, out);
+    }
+}
+
+void mipKaiserRow(MipPath path, const float* in, int width, int outWidth, const float* w, float* out) {
+    switch (path) {
+#ifdef SIMD_AVX2
+    case MipPath::AVX2: return mipKaiserRowAVX2(in, width, outWidth, w, out);
+#endif
+#ifdef SIMD_SSE
+    case MipPath::SSE: return mipKaiserRowSSE(in, width, outWidth, w, out);
+#endif
+    default: return mipKaiserRowScalar(in, width, outWidth, w, out);
+    }
+}
+
+void mipKaiserColumn(MipPath path, const float* const* rows, int outWidth, const float* w, float* out) {
+    switch (path) {
+#ifdef SIMD_AVX2
+    case MipPath::AVX2: return mipKaiserColumnAVX2(rows, outWidth, w, out);
+#endif
+#ifdef SIMD_SSE
+    case MipPath::SSE: return mipKaiserColumnSSE(rows, outWidth, w, out);
+#endif
+    default: return mipKaiserColumnScalar(rows, outWidth, w, out);
+    }
+}
+
+void mipNormalizeRow(MipPath path, float* row, int width) {
+#ifdef SIMD_SSE
+    if (path != MipPath::Scalar) return mipNormalizeRowSSE(row, width);
+#endif
+    mipNormalizeRowScalar(row, width);
+}
+
+// every level below src (level 0, tightly packed rows of components bytes a texel) back to back into dst, which
+// holds mipChainBytes. Levels are filtered from the float level above, not from the rounded bytes, so rounding does not
+// build up down the chain. Each level is split into bands of rows over jobs when given, the levels themselves follow
+// each other; without jobs everything runs on the calling thread, like on the TextureLoader's decode threads.
+void generateMipChain(JobSystem* jobs, const unsigned char* src, int width, int height, int components, unsigned char* dst,
+                      const MipOptions& options = MipOptions(), MipPath path = bestMipPath()) {
+    if (!mipPathSupported(path)) path = MipPath::Scalar;
+    auto forRows = [jobs](int rows, int width, const auto& fn) {
+        size_t grain = std::max(1, (32 << 10) / width); // about 32K texels a band
+        if (jobs) jobs->parallelFor(rows, grain, fn, "mipRows");
+        else fn(0, rows);
+    };
+    std::vector<float> level((size_t)width * height * 4), next, horizontal;
+    forRows(height, width, [&](size_t first, size_t last) {
+        for (size_t y = first; y < last; y++) mipLoadRow(path, src + y * width * components, width, components, options, &level[y * width * 4]);
+    });
+    const float* w = kaiserTaps().w;
+    for (int i = 1, count = mipLevelCount(width, height); i < count; i++) {
+        int outWidth = std::max(1, width / 2), outHeight = std::max(1, height / 2);
+        next.resize((size_t)outWidth * outHeight * 4);
+        // filtered rows are renormalized and stored right away while they are still in cache
+        auto finish = [&](size_t y) {
+            float* row = &next[y * outWidth * 4];
+            if (options.normalMap) mipNormalizeRow(path, row, outWidth);
+            mipStoreRow(path, row, outWidth, components, options, dst + y * outWidth * components);
+        };
+        if (options.filter == MipFilter::Box) {
+            forRows(outHeight, outWidth, [&](size_t first, size_t last) {
+                for (size_t y = first; y < last; y++) {
+                    const float* a = &level[std::min(2 * (int)y, height - 1) * (size_t)width * 4];
+                    const float* b = &level[std::min(2 * (int)y + 1, height - 1) * (size_t)width * 4];
+                    mipBoxRow(path, a, b, width, outWidth, &next[y * outWidth * 4]);
+                    finish(y);
+                }
+            });
+        } else {
+            horizontal.resize((size_t)outWidth * height * 4);
+            forRows(height, outWidth, [&](size_t first, size_t last) {
+                for (size_t y = first; y < last; y++) mipKaiserRow(path, &level[y * width * 4], width, outWidth, w, &horizontal[y * outWidth * 4]);
+            });
+            forRows(outHeight, outWidth, [&](size_t first, size_t last) {
+                for (size_t y = first; y < last; y++) {
+                    const float* rows[6];
+                    for (int k = 0; k < 6; k++) rows[k] = &horizontal[std::min(std::max(2 * (int)y - 2 + k, 0), height - 1) * (size_t)outWidth * 4];
+                    mipKaiserColumn(path, rows, outWidth, w, &next[y * outWidth * 4]);
+                    finish(y);
+                }
+            });
+        }
+        dst += (size_t)outWidth * outHeight * components;
+        level.swap(next);
+        width = outWidth;
+        height = outHeight;
+    }
+}
+
+#endif
\ No newline at end of file
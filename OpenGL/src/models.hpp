@@ -5,6 +5,9 @@
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <vector>
+#include <cmath>
+#include "glResource.hpp"
+#include "vertexLayout.hpp"
 
 float defTri[] = {
     0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f,   // bottom right
@@ -145,23 +148,38 @@ float defCubeWithNormTex[] = {
     -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
 };
 
+// vertex data from the createObj family, owns its GL objects
+struct VertexObject {
+    VertexArray VAO;
+    Buffer VBO, EBO;
+    GLsizei count = 0; // vertices for glDrawArrays, or indices when EBO is set
+
+    // expects VAO to be bound, like Mesh::draw
+    void draw() const {
+        if (EBO) glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0);
+        else glDrawArrays(GL_TRIANGLES, 0, count);
+    }
+};
+
+// uploaded once on the first call and kept for every later one
 void drawDef() {
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(defTri), defTri, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    static VertexArray VAO;
+    static Buffer VBO;
+    if (!VAO) {
+        VAO.generate();
+        VAO.bind();
+        VBO.data(GL_ARRAY_BUFFER, sizeof(defTri), defTri, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+    }
 
+    VAO.bind();
     glDrawArrays(GL_TRIANGLES, 0, 3);
 }
 
-std::vector<unsigned int> getShaders() {
+std::vector<Program> getShaders() {
     const char *vertexShaderSource = "#version 330 core\n"
     "layout (location = 0) in vec3 aPos;\n"
     "void main()\n"
@@ -197,8 +215,8 @@ std::vector<unsigned int> getShaders() {
         std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
     }
 
-    unsigned int orgShaderProgram;
-    orgShaderProgram = glCreateProgram();
+    std::vector<Program> programs(2);
+    GLuint orgShaderProgram = programs[0].generate();
     glAttachShader(orgShaderProgram, vertexShader);
     glAttachShader(orgShaderProgram, orgfragmentShader);
     glLinkProgram(orgShaderProgram);
@@ -224,8 +242,7 @@ std::vector<unsigned int> getShaders() {
         std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
     }
 
-    unsigned int yellowShaderProgram;
-    yellowShaderProgram = glCreateProgram();
+    GLuint yellowShaderProgram = programs[1].generate();
     glAttachShader(yellowShaderProgram, vertexShader);
     glAttachShader(yellowShaderProgram, yellowFragmentShader);
     glLinkProgram(yellowShaderProgram);
@@ -239,48 +256,64 @@ std::vector<unsigned int> getShaders() {
     glDeleteShader(orgfragmentShader);
     glDeleteShader(yellowFragmentShader);
 
-    return {orgShaderProgram, yellowShaderProgram};
+    return programs;
 }
 
-std::pair<unsigned int, unsigned int> createObj(float vertices[], float vtcSize, bool hasColor, bool hasTexture) {
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+// floats per vertex for the createObj layouts: position, then an optional color/normal, then optional uv
+int vertexStride(bool hasColor, bool hasTexture) { return objLayout(hasColor, hasTexture).stride / sizeof(float); }
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vtcSize, vertices, GL_STATIC_DRAW);
-    int stride = hasColor ? hasTexture ? 8 : 6 : hasTexture ? 5 : 3;
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    if (hasColor) {
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        if (hasTexture) {
-            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride * sizeof(float), (void*)(6 * sizeof(float)));
-            glEnableVertexAttribArray(2);
-        }
-    } else if (hasTexture) {
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-    }
+// attribute pointers for the bound VAO and GL_ARRAY_BUFFER, shared by every mesh in the createObj layout
+void setVertexAttribs(bool hasColor, bool hasTexture) { objLayout(hasColor, hasTexture).apply(); }
+
+VertexObject createObj(float vertices[], float vtcSize, bool hasColor, bool hasTexture) {
+    VertexObject obj;
+    obj.VAO.generate();
+    obj.VAO.bind();
+    obj.VBO.data(GL_ARRAY_BUFFER, vtcSize, vertices, GL_STATIC_DRAW);
+    int stride = vertexStride(hasColor, hasTexture);
+    setVertexAttribs(hasColor, hasTexture);
 
-    return std::make_pair(vtcSize / sizeof(float) / stride, VAO);
+    obj.count = vtcSize / sizeof(float) / stride;
+    return obj;
 }
 
-std::pair<unsigned int, unsigned int> createCubeWithNorm() {
+VertexObject createCubeWithNorm() {
     return createObj(defCubeWithNorm, sizeof(defCubeWithNorm), true, false); // NOTE: Used norm as color
 }
 
-std::pair<unsigned int, unsigned int> createCube() {
+VertexObject createCube() {
     return createObj(defCube, sizeof(defCube), false, false); // NOTE: Used norm as color
 }
 
-std::pair<unsigned int, unsigned int> createCubeWithNormTex() {
+VertexObject createCubeWithNormTex() {
     return createObj(defCubeWithNormTex, sizeof(defCubeWithNormTex), true, true);
 }
 
-std::pair<int, int> createTexCube() {
+// unit sphere as a triangle soup in the same position/normal/uv layout as defCubeWithNormTex
+std::vector<float> defSphereWithNormTex(int stacks, int slices) {
+    std::vector<float> vertices;
+    vertices.reserve((size_t)stacks * slices * 6 * 8);
+    auto push = [&](int stack, int slice) {
+        float u = (float)slice / slices, v = (float)stack / stacks;
+        float theta = u * 2.0f * (float)M_PI, phi = v * (float)M_PI;
+        float x = std::sin(phi) * std::cos(theta), y = std::cos(phi), z = std::sin(phi) * std::sin(theta);
+        vertices.insert(vertices.end(), { 0.5f * x, 0.5f * y, 0.5f * z, x, y, z, u, v });
+    };
+    for (int i = 0; i < stacks; i++) {
+        for (int j = 0; j < slices; j++) {
+            push(i, j); push(i + 1, j); push(i + 1, j + 1);
+            push(i + 1, j + 1); push(i, j + 1); push(i, j);
+        }
+    }
+    return vertices;
+}
+
+VertexObject createSphereWithNormTex(int stacks, int slices) {
+    std::vector<float> vertices = defSphereWithNormTex(stacks, slices);
+    return createObj(vertices.data(), vertices.size() * sizeof(float), true, true);
+}
+
+VertexObject createTexCube() {
     float verticesWithTex[] = {
         -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
         0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
@@ -327,7 +360,7 @@ std::pair<int, int> createTexCube() {
     return createObj(verticesWithTex, sizeof(verticesWithTex), false, true);
 }
 
-int createRect() {
+VertexObject createRect() {
     float vertices[] = {
         // positions          // colors           // texture coords
         0.5f,  0.5f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f,   // top right
@@ -341,17 +374,11 @@ int createRect() {
         1, 2, 3
     };
     
-    unsigned int VBO, VAO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    VertexObject rect;
+    rect.VAO.generate();
+    rect.VAO.bind();
+    rect.VBO.data(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    rect.EBO.data(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
@@ -359,7 +386,8 @@ int createRect() {
     glEnableVertexAttribArray(1);
     glEnableVertexAttribArray(2);
 
-    return 6;
+    rect.count = 6;
+    return rect;
 }
 
 void draw2Tri() {
@@ -372,17 +400,17 @@ void draw2Tri() {
         -0.5f, 0.5f, 0.0f,
     };
     
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    static VertexArray VAO;
+    static Buffer VBO;
+    if (!VAO) {
+        VAO.generate();
+        VAO.bind();
+        VBO.data(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+    }
 
+    VAO.bind();
     glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
@@ -397,29 +425,31 @@ void draw2TriAlt() {
         -1.0f,  -0.5f, 0.0f,  
         -0.5f, 0.5f, 0.0f,
     };
-    unsigned int VBOs[2], VAOs[2];
-    glGenVertexArrays(2, VBOs);
-    glGenBuffers(2, VAOs);
-
-    glBindVertexArray(VAOs[0]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices1), vertices1, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindVertexArray(VAOs[1]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices2), vertices2, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    static VertexArray VAOs[2];
+    static Buffer VBOs[2];
+    static std::vector<Program> shaderPrograms;
+    if (!VAOs[0]) {
+        VAOs[0].generate();
+        VAOs[0].bind();
+        VBOs[0].data(GL_ARRAY_BUFFER, sizeof(vertices1), vertices1, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        VAOs[1].generate();
+        VAOs[1].bind();
+        VBOs[1].data(GL_ARRAY_BUFFER, sizeof(vertices2), vertices2, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        shaderPrograms = getShaders();
+    }
 
-    auto shaderPrograms = getShaders();
-    glUseProgram(shaderPrograms[0]);
-    glBindVertexArray(VAOs[0]);
+    shaderPrograms[0].use();
+    VAOs[0].bind();
     glDrawArrays(GL_TRIANGLES, 0, 3);
 
-    glUseProgram(shaderPrograms[1]);
-    glBindVertexArray(VAOs[1]);
+    shaderPrograms[1].use();
+    VAOs[1].bind();
     glDrawArrays(GL_TRIANGLES, 0, 3);
 }
 
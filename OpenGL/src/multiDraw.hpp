@@ -0,0 +1,168 @@
+#ifndef MULTI_DRAW_H
+#define MULTI_DRAW_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "glResource.hpp"
+#include "glState.hpp"
+#include "mesh.hpp"
+#include "meshArena.hpp"
+#include "profiler.hpp"
+#include "shader.hpp"
+#include "transform.hpp"
+
+// what glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER for every draw
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// one entry of fullVtxIndirect.glsl's DrawBlock, std430 pads every mat3 column to a vec4
+struct IndirectDrawData {
+    glm::mat4 model;
+    glm::vec4 normal[3];
+};
+
+IndirectDrawData makeIndirectDrawData(const glm::mat4& model) {
+    glm::mat3 n = normalMatrix(model);
+    return { model, { glm::vec4(n[0], 0.0f), glm::vec4(n[1], 0.0f), glm::vec4(n[2], 0.0f) } };
+}
+
+// glMultiDrawElementsIndirect and SSBOs are core in 4.3, gl_BaseInstanceARB needs ARB_shader_draw_parameters on top
+bool multiDrawIndirectSupported() {
+    return glVersionAtLeast(4, 3) && hasGLExtension("GL_ARB_shader_draw_parameters");
+}
+
+// static meshes of one createObj layout sub-allocated from a MeshArena, every mesh a firstIndex/baseVertex range of
+// an arena page. Draws go out with one glMultiDrawElementsIndirect per page where the context has it, the commands
+// are built once and per draw model matrices live in an SSBO that is only rewritten where setModel touched it.
+// Each command carries its draw index as baseInstance, so the SSBO stays indexed by draw whatever page it landed on.
+// On older contexts (main asks for 3.3 unless told otherwise) the same draws go through a glDrawElementsBaseVertex loop.
+class IndirectBatch {
+private:
+    // consecutive commands of one page, one multi draw each
+    struct PageRun {
+        uint32_t mesh; // any mesh of the page, to bind its VAO
+        size_t first, count;
+    };
+    MeshArena arena;
+    Buffer commandBuffer, drawBuffer;
+    bool hasColor, hasTexture;
+    std::vector<uint32_t> meshes; // arena ids
+    std::vector<uint32_t> drawMeshes;
+    std::vector<IndirectDrawData> draws;
+    std::vector<glm::mat4> models;
+    std::vector<PageRun> runs;
+    size_t uploadedDraws = 0;
+    size_t dirtyBegin = SIZE_MAX, dirtyEnd = 0; // draws to rewrite before the next indirect draw
+
+    // commands sorted by page so every page is one run, only when draws were added
+    void buildCommands() {
+        std::vector<uint32_t> order(drawMeshes.size());
+        for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return arena.range(meshes[drawMeshes[a]]).page < arena.range(meshes[drawMeshes[b]]).page;
+        });
+        std::vector<DrawElementsIndirectCommand> commands;
+        runs.clear();
+        for (uint32_t draw : order) {
+            uint32_t mesh = meshes[drawMeshes[draw]];
+            const ArenaRange& range = arena.range(mesh);
+            if (runs.empty() || arena.range(runs.back().mesh).page != range.page) runs.push_back({ mesh, commands.size(), 0 });
+            runs.back().count++;
+            commands.push_back({ (GLuint)range.indexCount, 1, range.firstIndex, range.baseVertex, draw });
+        }
+        commandBuffer.data(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STATIC_DRAW);
+    }
+
+    void uploadDraws() {
+        if (draws.size() != uploadedDraws) {
+            buildCommands();
+            drawBuffer.data(GL_SHADER_STORAGE_BUFFER, draws.size() * sizeof(IndirectDrawData), draws.data(), GL_DYNAMIC_DRAW);
+            uploadedDraws = draws.size();
+        } else if (dirtyBegin < dirtyEnd) {
+            drawBuffer.subData(GL_SHADER_STORAGE_BUFFER, dirtyBegin * sizeof(IndirectDrawData), (dirtyEnd - dirtyBegin) * sizeof(IndirectDrawData),
+                               &draws[dirtyBegin]);
+        }
+        dirtyBegin = SIZE_MAX;
+        dirtyEnd = 0;
+    }
+public:
+    // decided once the context exists, false draws through the CPU loop even where indirect draws work
+    bool indirect;
+
+    IndirectBatch(bool hasColor = true, bool hasTexture = true)
+        : hasColor(hasColor), hasTexture(hasTexture), indirect(multiDrawIndirectSupported()) {}
+
+    // uploaded into the arena right away, returns the mesh id for addDraw
+    uint32_t addMesh(const MeshData& data) {
+        if (data.hasColor != hasColor || data.hasTexture != hasTexture) {
+            std::cerr << "ERROR::INDIRECT_BATCH::LAYOUT_MISMATCH" << std::endl;
+            return ~0u;
+        }
+        uint32_t id = uploadArenaMesh(arena, data);
+        if (id == ~0u) return ~0u;
+        meshes.push_back(id);
+        return (uint32_t)meshes.size() - 1;
+    }
+
+    // the createObj arguments, welded and optimized like createMesh before going into the arena
+    uint32_t addObj(const float* soup, size_t vtcSize) {
+        MeshBuilder builder(hasColor, hasTexture);
+        builder.addTriangles(soup, vtcSize / sizeof(float));
+        MeshData data = builder.build();
+        optimizeMesh(data);
+        return addMesh(data);
+    }
+
+    uint32_t addDraw(uint32_t mesh, const glm::mat4& model) {
+        drawMeshes.push_back(mesh);
+        draws.push_back(makeIndirectDrawData(model));
+        models.push_back(model);
+        return (uint32_t)draws.size() - 1;
+    }
+
+    void setModel(uint32_t draw, const glm::mat4& model) {
+        models[draw] = model;
+        draws[draw] = makeIndirectDrawData(model);
+        dirtyBegin = std::min(dirtyBegin, (size_t)draw);
+        dirtyEnd = std::max(dirtyEnd, (size_t)draw + 1);
+    }
+
+    // shader is in use with projection (and view if it reads it) set: fullVtxIndirect.glsl when indirect, fullVtx.glsl otherwise
+    void draw(const Shader& shader, const glm::mat4& view) {
+        PROFILE_SCOPE("indirectBatch");
+        if (draws.empty()) return;
+        if (indirect) {
+            uploadDraws();
+            commandBuffer.bind(GL_DRAW_INDIRECT_BUFFER);
+            glState().bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, drawBuffer.id());
+            for (const PageRun& run : runs) {
+                arena.bind(run.mesh);
+                glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(run.first * sizeof(DrawElementsIndirectCommand)),
+                                            (GLsizei)run.count, 0);
+            }
+            return;
+        }
+        ObjectTransform transform(shader);
+        for (size_t i = 0; i < draws.size(); i++) {
+            uint32_t mesh = meshes[drawMeshes[i]];
+            arena.bind(mesh); // the state cache drops it while the page stays the same
+            transform.set(shader, view, models[i]);
+            arena.draw(mesh);
+        }
+    }
+
+    const ArenaRange& mesh(uint32_t id) const { return arena.range(meshes[id]); }
+    size_t meshCount() const { return meshes.size(); }
+    size_t drawCount() const { return draws.size(); }
+};
+
+#endif
\ No newline at end of file
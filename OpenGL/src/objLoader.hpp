@@ -0,0 +1,290 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "mappedFile.hpp"
+#include "mesh.hpp"
+#include "quantize.hpp"
+
+// one face corner resolved to zero-based indices, -1 when the attribute is absent
+struct ObjCorner {
+    int v, vt, vn;
+};
+
+// a line aligned slice of the file, parsed by one thread
+struct ObjChunk {
+    const char* begin;
+    const char* end;
+    size_t positions = 0, uvs = 0, normals = 0, corners = 0;
+    size_t positionBase = 0, uvBase = 0, normalBase = 0, cornerBase = 0;
+    bool failed = false;
+};
+
+const char* objSkipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    return p;
+}
+
+const char* objNextLine(const char* p, const char* end) {
+    while (p < end && *p != '\n') p++;
+    return p < end ? p + 1 : end;
+}
+
+// decimal float without locale or allocation, accurate to float precision for the usual OBJ notation
+const char* objParseFloat(const char* p, const char* end, float& out) {
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    p = objSkipSpaces(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (digits < 18) {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        } else exponent++;
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (digits < 18) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negativeExp = false;
+        if (p < end && (*p == '-' || *p == '+')) negativeExp = *p++ == '-';
+        int e = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p++) e = std::min(e * 10 + (*p - '0'), 1000);
+        exponent += negativeExp ? -e : e;
+    }
+    double value = (double)mantissa;
+    if (exponent < 0) value = exponent >= -22 ? value / powers[-exponent] : value * std::pow(10.0, exponent);
+    else if (exponent > 0) value = exponent <= 22 ? value * powers[exponent] : value * std::pow(10.0, exponent);
+    out = (float)(negative ? -value : value);
+    return p;
+}
+
+const char* objParseInt(const char* p, const char* end, int& out, bool& ok) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+    const char* start = p;
+    long long value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) value = std::min(value * 10 + (*p - '0'), (long long)INT32_MAX);
+    ok = p != start;
+    out = (int)(negative ? -value : value);
+    return p;
+}
+
+// OBJ indices are one-based, negative ones count back from the latest element declared before the face
+int objResolve(int index, size_t declared, size_t total, bool& ok) {
+    long long resolved = index < 0 ? (long long)declared + index : (long long)index - 1;
+    if (index == 0 || resolved < 0 || resolved >= (long long)total) {
+        ok = false;
+        return 0;
+    }
+    return (int)resolved;
+}
+
+// first pass, only counts what the chunk declares so every thread knows where its output starts
+void objCountChunk(ObjChunk& chunk) {
+    for (const char* p = chunk.begin; p < chunk.end; p = objNextLine(p, chunk.end)) {
+        p = objSkipSpaces(p, chunk.end);
+        if (chunk.end - p < 2) continue;
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) chunk.positions++;
+        else if (p[0] == 'v' && p[1] == 't') chunk.uvs++;
+        else if (p[0] == 'v' && p[1] == 'n') chunk.normals++;
+        else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+            // fan triangulation turns a polygon of n corners into 3 * (n - 2)
+            size_t n = 0;
+            for (p += 2; p < chunk.end && *p != '\n';) {
+                p = objSkipSpaces(p, chunk.end);
+                if (p >= chunk.end || *p == '\n' || *p == '#') break;
+                n++;
+                while (p < chunk.end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+            }
+            if (n >= 3) chunk.corners += 3 * (n - 2);
+        }
+    }
+}
+
+// second pass, writes straight into the shared arrays at the offsets the count pass produced
+void objParseChunk(ObjChunk& chunk, float* positions, float* uvs, float* normals, ObjCorner* corners,
+                   size_t totalPositions, size_t totalUvs, size_t totalNormals) {
+    size_t v = chunk.positionBase, vt = chunk.uvBase, vn = chunk.normalBase, c = chunk.cornerBase;
+    for (const char* p = chunk.begin; p < chunk.end; p = objNextLine(p, chunk.end)) {
+        p = objSkipSpaces(p, chunk.end);
+        if (chunk.end - p < 2) continue;
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+            p = objParseFloat(p + 2, chunk.end, positions[v * 3]);
+            p = objParseFloat(p, chunk.end, positions[v * 3 + 1]);
+            objParseFloat(p, chunk.end, positions[v * 3 + 2]);
+            v++;
+        } else if (p[0] == 'v' && p[1] == 't') {
+            p = objParseFloat(p + 2, chunk.end, uvs[vt * 2]);
+            objParseFloat(p, chunk.end, uvs[vt * 2 + 1]);
+            vt++;
+        } else if (p[0] == 'v' && p[1] == 'n') {
+            p = objParseFloat(p + 2, chunk.end, normals[vn * 3]);
+            p = objParseFloat(p, chunk.end, normals[vn * 3 + 1]);
+            objParseFloat(p, chunk.end, normals[vn * 3 + 2]);
+            vn++;
+        } else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+            ObjCorner first = { 0, -1, -1 }, previous = { 0, -1, -1 };
+            size_t n = 0;
+            for (p += 2;;) {
+                p = objSkipSpaces(p, chunk.end);
+                if (p >= chunk.end || *p == '\n' || *p == '#') break;
+                ObjCorner corner = { 0, -1, -1 };
+                int index;
+                bool ok = true, parsed;
+                p = objParseInt(p, chunk.end, index, parsed);
+                corner.v = objResolve(index, v, totalPositions, ok);
+                if (p < chunk.end && *p == '/') {
+                    p++;
+                    p = objParseInt(p, chunk.end, index, parsed);
+                    if (parsed) corner.vt = objResolve(index, vt, totalUvs, ok);
+                    if (p < chunk.end && *p == '/') {
+                        p = objParseInt(p + 1, chunk.end, index, parsed);
+                        if (parsed) corner.vn = objResolve(index, vn, totalNormals, ok);
+                    }
+                }
+                while (p < chunk.end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+                if (!ok) chunk.failed = true;
+                if (n >= 2) {
+                    corners[c++] = first;
+                    corners[c++] = previous;
+                    corners[c++] = corner;
+                }
+                if (n == 0) first = corner;
+                previous = corner;
+                n++;
+            }
+        }
+    }
+}
+
+struct ObjStats {
+    size_t bytes = 0, positions = 0, uvs = 0, normals = 0, triangles = 0, vertices = 0;
+};
+
+// mmaps an OBJ and parses it on every core into a welded MeshData in the createObj layout,
+// normals take the color slot like defCubeWithNormTex
+bool loadObj(const char* path, MeshData& mesh, ObjStats* stats = nullptr, unsigned int threads = 0) {
+    MappedFile file(path);
+    if (!file.valid()) return false;
+    file.adviseSequential();
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    threads = (unsigned int)std::max<size_t>(1, std::min<size_t>(threads, file.size() / (1 << 16)));
+
+    std::vector<ObjChunk> chunks(threads);
+    const char* cursor = begin;
+    for (unsigned int i = 0; i < threads; i++) {
+        chunks[i].begin = cursor;
+        cursor = i + 1 == threads ? end : std::max(cursor, objNextLine(begin + file.size() * (i + 1) / threads - 1, end));
+        chunks[i].end = cursor;
+    }
+
+    auto parallel = [&](auto&& work) {
+        std::vector<std::thread> workers;
+        for (unsigned int i = 1; i < threads; i++) workers.emplace_back(work, i);
+        work(0);
+        for (auto& worker : workers) worker.join();
+    };
+    parallel([&](unsigned int i) { objCountChunk(chunks[i]); });
+
+    size_t positions = 0, uvs = 0, normals = 0, corners = 0;
+    for (ObjChunk& chunk : chunks) {
+        chunk.positionBase = positions;
+        chunk.uvBase = uvs;
+        chunk.normalBase = normals;
+        chunk.cornerBase = corners;
+        positions += chunk.positions;
+        uvs += chunk.uvs;
+        normals += chunk.normals;
+        corners += chunk.corners;
+    }
+    std::vector<float> positionData(positions * 3), uvData(uvs * 2), normalData(normals * 3);
+    std::vector<ObjCorner> cornerData(corners);
+    parallel([&](unsigned int i) {
+        objParseChunk(chunks[i], positionData.data(), uvData.data(), normalData.data(), cornerData.data(), positions, uvs, normals);
+    });
+    for (ObjChunk& chunk : chunks) {
+        if (chunk.failed) {
+            std::cout << "ERROR::OBJ::INDEX_OUT_OF_RANGE " << path << std::endl;
+            return false;
+        }
+    }
+
+    // weld identical v/vt/vn triplets into one vertex each
+    mesh = MeshData();
+    // uvs must stay at location 2, so an OBJ without normals still gets a zeroed normal slot
+    mesh.hasColor = normals > 0 || uvs > 0;
+    mesh.hasTexture = uvs > 0;
+    int stride = mesh.stride();
+    mesh.indices.resize(corners);
+    size_t capacity = 64;
+    while (capacity < corners * 2) capacity <<= 1;
+    std::vector<unsigned int> slots(capacity, ~0u);
+    std::vector<ObjCorner> unique;
+    unique.reserve(corners / 4);
+    mesh.vertices.reserve(corners / 4 * stride);
+    for (size_t i = 0; i < corners; i++) {
+        ObjCorner corner = cornerData[i];
+        if (normals == 0) corner.vn = -1;
+        if (!mesh.hasTexture) corner.vt = -1;
+        uint32_t h = (uint32_t)corner.v * 73856093u ^ (uint32_t)corner.vt * 19349663u ^ (uint32_t)corner.vn * 83492791u;
+        size_t slot = (h ^ (h >> 16)) & (capacity - 1);
+        for (; slots[slot] != ~0u; slot = (slot + 1) & (capacity - 1)) {
+            const ObjCorner& other = unique[slots[slot]];
+            if (other.v == corner.v && other.vt == corner.vt && other.vn == corner.vn) break;
+        }
+        if (slots[slot] == ~0u) {
+            slots[slot] = (unsigned int)unique.size();
+            unique.push_back(corner);
+            const float* pos = &positionData[(size_t)corner.v * 3];
+            mesh.vertices.insert(mesh.vertices.end(), pos, pos + 3);
+            if (mesh.hasColor) {
+                if (corner.vn >= 0) mesh.vertices.insert(mesh.vertices.end(), &normalData[(size_t)corner.vn * 3], &normalData[(size_t)corner.vn * 3] + 3);
+                else mesh.vertices.insert(mesh.vertices.end(), { 0.0f, 0.0f, 0.0f });
+            }
+            if (mesh.hasTexture) {
+                if (corner.vt >= 0) mesh.vertices.insert(mesh.vertices.end(), &uvData[(size_t)corner.vt * 2], &uvData[(size_t)corner.vt * 2] + 2);
+                else mesh.vertices.insert(mesh.vertices.end(), { 0.0f, 0.0f });
+            }
+        }
+        mesh.indices[i] = slots[slot];
+    }
+
+    if (stats) {
+        stats->bytes = file.size();
+        stats->positions = positions;
+        stats->uvs = uvs;
+        stats->normals = normals;
+        stats->triangles = corners / 3;
+        stats->vertices = unique.size();
+    }
+    return true;
+}
+
+// loads, optionally reorders for the vertex cache, and uploads like createObj would
+bool createObjMesh(const char* path, Mesh& mesh, bool optimize = true, bool quantize = false) {
+    MeshData data;
+    if (!loadObj(path, data)) return false;
+    if (optimize) optimizeMesh(data);
+    mesh = quantize ? uploadQuantizedMesh(data) : uploadMesh(data);
+    return true;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,216 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "glResource.hpp"
+#include "trace.hpp"
+
+// last WINDOW samples of one measurement, oldest overwritten first
+class RollingWindow {
+private:
+    std::vector<double> samples;
+    size_t next = 0;
+public:
+    static const size_t WINDOW = 512;
+
+    void add(double ms) {
+        if (samples.size() < WINDOW) samples.push_back(ms);
+        else samples[next] = ms;
+        next = (next + 1) % WINDOW;
+    }
+
+    bool empty() const { return samples.empty(); }
+
+    void summary(double& minMs, double& avgMs, double& p99Ms) const {
+        std::vector<double> sorted(samples);
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (double s : sorted) total += s;
+        minMs = sorted.front();
+        avgMs = total / sorted.size();
+        p99Ms = sorted[std::min(sorted.size() - 1, (size_t)(sorted.size() * 0.99))];
+    }
+};
+
+// CPU and GPU time per named scope, main thread only since the GPU side needs the context.
+// GPU time comes from a pair of GL_TIMESTAMP counters per scope rather than GL_TIME_ELAPSED, which cannot nest.
+// Queries of a frame are read back RING frames later, by then the GPU is normally done with them.
+class Profiler {
+private:
+    struct Scope {
+        const char* name; // literal from PROFILE_SCOPE, trace events keep the pointer
+        int depth;
+        size_t calls = 0;
+        RollingWindow cpu, gpu;
+
+        Scope(const char* name, int depth) : name(name), depth(depth) {}
+    };
+    struct PendingScope {
+        int scope;
+        size_t begin, end; // indices into FrameSlot::queries
+    };
+    struct FrameSlot {
+        std::vector<Query> queries;
+        size_t used = 0;
+        std::vector<PendingScope> pending;
+    };
+    static const int RING = 4;
+
+    std::vector<Scope> scopes;
+    FrameSlot slots[RING];
+    uint64_t frame = 0;
+    int depth = 0;
+    size_t stalls = 0;
+    int frameScope = -1;
+    std::chrono::steady_clock::time_point lastFrame;
+
+    size_t timestamp() {
+        FrameSlot& slot = slots[frame % RING];
+        if (slot.used == slot.queries.size()) {
+            slot.queries.emplace_back();
+            slot.queries.back().generate();
+        }
+        glQueryCounter(slot.queries[slot.used].id(), GL_TIMESTAMP);
+        return slot.used++;
+    }
+
+    void collect(FrameSlot& slot) {
+        for (const PendingScope& p : slot.pending) {
+            if (p.end == SIZE_MAX) continue; // scope straddled newFrame
+            GLint available = 0;
+            glGetQueryObjectiv(slot.queries[p.end].id(), GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) stalls++;
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(slot.queries[p.begin].id(), GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(slot.queries[p.end].id(), GL_QUERY_RESULT, &end);
+            scopes[p.scope].gpu.add(end > begin ? (end - begin) / 1e6 : 0.0);
+            if (tracer().active()) tracer().gpu(scopes[p.scope].name, begin, end);
+        }
+        slot.pending.clear();
+        slot.used = 0;
+    }
+public:
+    bool enabled = false;
+    bool gpuTimers = true;
+    int reportEvery = 0; // frames between printed summaries, 0 for never
+
+    // looked up once per PROFILE_SCOPE site, the depth printed is the one seen on first use
+    int scopeId(const char* name) {
+        for (size_t i = 0; i < scopes.size(); i++)
+            if (!strcmp(scopes[i].name, name)) return (int)i;
+        scopes.emplace_back(name, depth);
+        return (int)scopes.size() - 1;
+    }
+
+    // returns the pending GPU entry to close in endScope, or -1 without GPU timing
+    int beginScope(int scope) {
+        depth++;
+        if (!gpuTimers) return -1;
+        FrameSlot& slot = slots[frame % RING];
+        slot.pending.push_back({ scope, timestamp(), SIZE_MAX });
+        return (int)slot.pending.size() - 1;
+    }
+
+    void endScope(int scope, int pending, uint64_t beganFrame, double cpuMs) {
+        depth--;
+        scopes[scope].calls++;
+        scopes[scope].cpu.add(cpuMs);
+        if (pending >= 0 && beganFrame == frame) slots[frame % RING].pending[pending].end = timestamp();
+    }
+
+    uint64_t currentFrame() const { return frame; }
+    const char* scopeName(int scope) const { return scopes[scope].name; }
+
+    // scopes are timed while the summary is on or a trace is being captured
+    bool recording() const { return enabled || tracer().active(); }
+
+    // call once at the top of every frame, the "frame" row is the time between calls
+    void newFrame() {
+        if (!recording()) return;
+        auto now = std::chrono::steady_clock::now();
+        if (frameScope < 0) frameScope = scopeId("frame");
+        else if (frame > 0) {
+            scopes[frameScope].calls++;
+            scopes[frameScope].cpu.add(std::chrono::duration<double, std::milli>(now - lastFrame).count());
+        }
+        lastFrame = now;
+        frame++;
+        collect(slots[frame % RING]);
+        if (tracer().active()) tracer().instant("frame", "frame", (int64_t)frame);
+        tracer().frame();
+        if (enabled && reportEvery > 0 && frame % reportEvery == 0) print();
+    }
+
+    void print() const {
+        std::cout << "profile at frame " << frame << ", last " << RollingWindow::WINDOW << " samples per scope, "
+                  << stalls << " GPU readback stalls" << std::endl;
+        std::cout << std::left << std::setw(28) << "scope (ms)" << std::right << std::setw(8) << "calls"
+                  << std::setw(10) << "cpu min" << std::setw(10) << "avg" << std::setw(10) << "p99"
+                  << std::setw(10) << "gpu min" << std::setw(10) << "avg" << std::setw(10) << "p99" << std::endl;
+        for (const Scope& s : scopes) {
+            std::cout << std::left << std::setw(28) << std::string(s.depth * 2, ' ') + s.name << std::right << std::setw(8)
+                      << s.calls << std::fixed << std::setprecision(4);
+            double minMs, avgMs, p99Ms;
+            for (const RollingWindow* w : { &s.cpu, &s.gpu }) {
+                if (w->empty()) {
+                    std::cout << std::setw(10) << "-" << std::setw(10) << "-" << std::setw(10) << "-";
+                    continue;
+                }
+                w->summary(minMs, avgMs, p99Ms);
+                std::cout << std::setw(10) << minMs << std::setw(10) << avgMs << std::setw(10) << p99Ms;
+            }
+            std::cout << std::endl;
+        }
+    }
+};
+
+// never destroyed, like glResources
+Profiler& profiler() {
+    static Profiler* instance = new Profiler();
+    return *instance;
+}
+
+// RAII marker behind PROFILE_SCOPE, costs one branch while neither the profiler nor a trace is on
+class ProfileScope {
+private:
+    int scope = -1, pending = -1;
+    uint64_t frame = 0;
+    std::chrono::steady_clock::time_point start;
+public:
+    explicit ProfileScope(int scopeId) {
+        Profiler& p = profiler();
+        if (!p.recording()) return;
+        scope = scopeId;
+        frame = p.currentFrame();
+        pending = p.beginScope(scope);
+        start = std::chrono::steady_clock::now();
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+    ~ProfileScope() {
+        if (scope < 0) return;
+        auto end = std::chrono::steady_clock::now();
+        profiler().endScope(scope, pending, frame, std::chrono::duration<double, std::milli>(end - start).count());
+        if (tracer().active()) {
+            int64_t startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count();
+            tracer().complete(profiler().scopeName(scope), "scope", startNs, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+    }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+// times the rest of the enclosing block under name
+#define PROFILE_SCOPE(name) \
+    static const int PROFILE_CONCAT(profileScopeId, __LINE__) = profiler().scopeId(name); \
+    ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileScopeId, __LINE__))
+
+#endif
\ No newline at end of file
@@ -0,0 +1,189 @@
+#ifndef QUANTIZE_H
+#define QUANTIZE_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "mesh.hpp"
+#include "vertexLayout.hpp"
+
+// compressed counterpart of the createObj layouts, 16 instead of 32 bytes for position/normal/uv:
+// unorm16 positions inside the mesh AABB (w is padding), 10:10:10 snorm normals, unorm16 uvs inside the uv bounds
+struct QuantizedVertices {
+    std::vector<uint8_t> bytes;
+    VertexLayout layout;
+    VertexDecode decode;
+};
+
+uint16_t packUnorm16(float v) { return (uint16_t)std::lround(std::min(std::max(v, 0.0f), 1.0f) * 65535.0f); }
+float unpackUnorm16(uint16_t v) { return v / 65535.0f; }
+
+// x in the low bits and w left at zero, read back by GL_INT_2_10_10_10_REV with normalized set
+uint32_t packSnorm10x3(float x, float y, float z) {
+    auto pack = [](float v) { return (uint32_t)((int32_t)std::lround(std::min(std::max(v, -1.0f), 1.0f) * 511.0f) & 0x3ff); };
+    return pack(x) | pack(y) << 10 | pack(z) << 20;
+}
+
+// the GL 4.2+ conversion, 3.3/4.1 drivers may use (2c + 1) / 1023 instead which is off by at most half a step
+float unpackSnorm10(uint32_t packed, int component) {
+    int32_t c = (int32_t)(packed << (22 - component * 10)) >> 22;
+    return std::max(c / 511.0f, -1.0f);
+}
+
+QuantizedVertices quantizeVertices(const MeshData& data) {
+    QuantizedVertices q;
+    int stride = data.stride();
+    size_t count = data.vertexCount();
+
+    float posMin[3], posMax[3], uvMin[2] = { 0.0f, 0.0f }, uvMax[2] = { 0.0f, 0.0f };
+    for (int c = 0; c < 3; c++) posMin[c] = posMax[c] = count ? data.vertices[c] : 0.0f;
+    int uvAt = data.hasColor ? 6 : 3;
+    if (data.hasTexture && count) {
+        for (int c = 0; c < 2; c++) uvMin[c] = uvMax[c] = data.vertices[uvAt + c];
+    }
+    for (size_t v = 0; v < count; v++) {
+        const float* vtx = &data.vertices[v * stride];
+        for (int c = 0; c < 3; c++) {
+            posMin[c] = std::min(posMin[c], vtx[c]);
+            posMax[c] = std::max(posMax[c], vtx[c]);
+        }
+        for (int c = 0; data.hasTexture && c < 2; c++) {
+            uvMin[c] = std::min(uvMin[c], vtx[uvAt + c]);
+            uvMax[c] = std::max(uvMax[c], vtx[uvAt + c]);
+        }
+    }
+    for (int c = 0; c < 3; c++) {
+        q.decode.posOffset[c] = posMin[c];
+        q.decode.posScale[c] = posMax[c] - posMin[c];
+    }
+    for (int c = 0; data.hasTexture && c < 2; c++) {
+        q.decode.uvOffset[c] = uvMin[c];
+        q.decode.uvScale[c] = uvMax[c] - uvMin[c];
+    }
+
+    uint32_t offset = 0;
+    q.layout.add(0, 4, GL_UNSIGNED_SHORT, true, offset);
+    offset += 4 * sizeof(uint16_t);
+    if (data.hasColor) {
+        q.layout.add(1, 4, GL_INT_2_10_10_10_REV, true, offset);
+        offset += sizeof(uint32_t);
+    }
+    if (data.hasTexture) {
+        q.layout.add(data.hasColor ? 2 : 1, 2, GL_UNSIGNED_SHORT, true, offset);
+        offset += 2 * sizeof(uint16_t);
+    }
+    q.layout.stride = offset;
+
+    // a flat axis has zero extent and quantizes to 0, the offset alone reconstructs it
+    auto relative = [](float v, float offset, float scale) { return scale > 0.0f ? (v - offset) / scale : 0.0f; };
+    q.bytes.resize(count * q.layout.stride);
+    for (size_t v = 0; v < count; v++) {
+        const float* vtx = &data.vertices[v * stride];
+        uint8_t* out = &q.bytes[v * q.layout.stride];
+        uint16_t pos[4] = { 0, 0, 0, 0 };
+        for (int c = 0; c < 3; c++) pos[c] = packUnorm16(relative(vtx[c], q.decode.posOffset[c], q.decode.posScale[c]));
+        memcpy(out, pos, sizeof(pos));
+        out += sizeof(pos);
+        if (data.hasColor) {
+            uint32_t normal = packSnorm10x3(vtx[3], vtx[4], vtx[5]);
+            memcpy(out, &normal, sizeof(normal));
+            out += sizeof(normal);
+        }
+        if (data.hasTexture) {
+            uint16_t uv[2];
+            for (int c = 0; c < 2; c++) uv[c] = packUnorm16(relative(vtx[uvAt + c], q.decode.uvOffset[c], q.decode.uvScale[c]));
+            memcpy(out, uv, sizeof(uv));
+        }
+    }
+    return q;
+}
+
+struct QuantizationError {
+    size_t floatBytes = 0, quantizedBytes = 0;
+    float maxPosition = 0.0f;         // object space units
+    float maxPositionRelative = 0.0f; // fraction of the AABB diagonal
+    float maxNormalDegrees = 0.0f, avgNormalDegrees = 0.0f;
+    float maxUv = 0.0f;
+};
+
+// decodes every vertex the way the vertex shader will and compares against the float source
+QuantizationError measureQuantization(const MeshData& data, const QuantizedVertices& q) {
+    QuantizationError err;
+    int stride = data.stride();
+    size_t count = data.vertexCount();
+    err.floatBytes = data.vertices.size() * sizeof(float);
+    err.quantizedBytes = q.bytes.size();
+    int uvAt = data.hasColor ? 6 : 3;
+    double normalSum = 0.0;
+    size_t normalCount = 0;
+    for (size_t v = 0; v < count; v++) {
+        const float* vtx = &data.vertices[v * stride];
+        const uint8_t* in = &q.bytes[v * q.layout.stride];
+        uint16_t pos[4];
+        memcpy(pos, in, sizeof(pos));
+        in += sizeof(pos);
+        for (int c = 0; c < 3; c++) {
+            float decoded = q.decode.posOffset[c] + q.decode.posScale[c] * unpackUnorm16(pos[c]);
+            err.maxPosition = std::max(err.maxPosition, std::fabs(decoded - vtx[c]));
+        }
+        if (data.hasColor) {
+            uint32_t packed;
+            memcpy(&packed, in, sizeof(packed));
+            in += sizeof(packed);
+            float n[3] = { unpackSnorm10(packed, 0), unpackSnorm10(packed, 1), unpackSnorm10(packed, 2) };
+            float lenA = std::sqrt(vtx[3] * vtx[3] + vtx[4] * vtx[4] + vtx[5] * vtx[5]);
+            float lenB = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (lenA > 0.0f && lenB > 0.0f) {
+                float cosine = (vtx[3] * n[0] + vtx[4] * n[1] + vtx[5] * n[2]) / (lenA * lenB);
+                float degrees = std::acos(std::min(std::max(cosine, -1.0f), 1.0f)) * 180.0f / (float)M_PI;
+                err.maxNormalDegrees = std::max(err.maxNormalDegrees, degrees);
+                normalSum += degrees;
+                normalCount++;
+            }
+        }
+        if (data.hasTexture) {
+            uint16_t uv[2];
+            memcpy(uv, in, sizeof(uv));
+            for (int c = 0; c < 2; c++) {
+                float decoded = q.decode.uvOffset[c] + q.decode.uvScale[c] * unpackUnorm16(uv[c]);
+                err.maxUv = std::max(err.maxUv, std::fabs(decoded - vtx[uvAt + c]));
+            }
+        }
+    }
+    const float* s = q.decode.posScale;
+    float diagonal = std::sqrt(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+    err.maxPositionRelative = diagonal > 0.0f ? err.maxPosition / diagonal : 0.0f;
+    err.avgNormalDegrees = normalCount ? (float)(normalSum / normalCount) : 0.0f;
+    return err;
+}
+
+void printQuantizationError(const std::string& name, const QuantizationError& err) {
+    std::cout << name << ": " << err.floatBytes << " -> " << err.quantizedBytes << " vertex bytes, position max "
+              << err.maxPosition << " (" << err.maxPositionRelative * 100.0f << "% of AABB diagonal), normal max "
+              << err.maxNormalDegrees << " deg avg " << err.avgNormalDegrees << " deg, uv max " << err.maxUv << std::endl;
+}
+
+// like uploadMesh, the shader has to decode with mesh.decode, see fullVtxQuantized.glsl
+Mesh uploadQuantizedMesh(const MeshData& data, QuantizationError* err = nullptr) {
+    QuantizedVertices q = quantizeVertices(data);
+    if (err) *err = measureQuantization(data, q);
+    Mesh mesh = uploadMeshIndexed(q.layout, q.bytes.data(), q.bytes.size(), data.indices, data.vertexCount());
+    mesh.quantized = true;
+    mesh.decode = q.decode;
+    return mesh;
+}
+
+Mesh createQuantizedCubeWithNormTex() {
+    MeshBuilder builder(true, true);
+    builder.addTriangles(defCubeWithNormTex, sizeof(defCubeWithNormTex) / sizeof(float));
+    MeshData data = builder.build();
+    optimizeMesh(data);
+    return uploadQuantizedMesh(data);
+}
+
+#endif
\ No newline at end of file
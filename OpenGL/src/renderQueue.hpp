@@ -0,0 +1,210 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#include "glResource.hpp"
+#include "mesh.hpp"
+#include "profiler.hpp"
+#include "shader.hpp"
+#include "transform.hpp"
+
+enum class RenderPass : uint32_t { Opaque, Unlit, Transparent };
+
+// 64-bit draw sort key, most significant first: pass 4 | program 10 | material 14 | mesh 14 | depth bucket 20 bits.
+// Opaque passes sort front to back inside a mesh run. Blending needs the whole transparent pass back to front, so
+// there the depth bucket moves up under the pass: pass 4 | depth bucket 20 | program 10 | material 14 | mesh 14,
+// and state only groups draws that share a bucket.
+const int SORT_DEPTH_BITS = 20, SORT_MESH_BITS = 14, SORT_MATERIAL_BITS = 14, SORT_PROGRAM_BITS = 10;
+
+uint64_t makeSortKey(uint32_t pass, uint32_t program, uint32_t material, uint32_t mesh, uint32_t depth) {
+    auto field = [](uint32_t value, int bits) { return (uint64_t)(value & ((1u << bits) - 1)); };
+    uint64_t state = field(program, SORT_PROGRAM_BITS);
+    state = state << SORT_MATERIAL_BITS | field(material, SORT_MATERIAL_BITS);
+    state = state << SORT_MESH_BITS | field(mesh, SORT_MESH_BITS);
+    const int stateBits = SORT_PROGRAM_BITS + SORT_MATERIAL_BITS + SORT_MESH_BITS;
+    uint64_t key = pass;
+    if (pass == (uint32_t)RenderPass::Transparent) {
+        key = key << SORT_DEPTH_BITS | field(depth, SORT_DEPTH_BITS);
+        return key << stateBits | state;
+    }
+    key = key << stateBits | state;
+    return key << SORT_DEPTH_BITS | field(depth, SORT_DEPTH_BITS);
+}
+
+// a program plus the textures it samples and how, each pair bound to units 0..n-1. One texture can sit on several
+// units under different samplers, a null sampler leaves the texture's own parameters in charge.
+struct Material {
+    static const int MAX_TEXTURES = 4;
+    Shader* shader = nullptr;
+    const Texture* textures[MAX_TEXTURES] = {};
+    const Sampler* samplers[MAX_TEXTURES] = {};
+    const char* colorUniform = nullptr; // optional vec3 set from DrawItem::color, e.g. lightSrc.glsl's lightColor
+};
+
+struct DrawItem {
+    uint64_t key;
+    const Mesh* mesh;
+    uint32_t material;
+    glm::mat4 model;
+    glm::vec3 color;
+};
+
+struct RenderQueueStats {
+    size_t draws = 0, programChanges = 0, materialChanges = 0, meshChanges = 0;
+};
+
+// LSD radix sort of (key, index) pairs, 8 bits a pass, passes where every key has the same byte are skipped
+struct SortEntry {
+    uint64_t key;
+    uint32_t index;
+};
+
+void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch) {
+    size_t n = entries.size();
+    scratch.resize(n);
+    size_t counts[8][256] = {};
+    for (const SortEntry& e : entries)
+        for (int b = 0; b < 8; b++) counts[b][(e.key >> (b * 8)) & 0xff]++;
+    SortEntry* src = entries.data();
+    SortEntry* dst = scratch.data();
+    for (int b = 0; b < 8; b++) {
+        size_t* count = counts[b];
+        if (n == 0 || count[(src[0].key >> (b * 8)) & 0xff] == n) continue;
+        size_t offsets[256], sum = 0;
+        for (int i = 0; i < 256; i++) {
+            offsets[i] = sum;
+            sum += count[i];
+        }
+        for (size_t i = 0; i < n; i++) dst[offsets[(src[i].key >> (b * 8)) & 0xff]++] = src[i];
+        std::swap(src, dst);
+    }
+    if (src != entries.data()) memcpy(entries.data(), src, n * sizeof(SortEntry));
+}
+
+// samples submit DrawItems each frame, execute sorts them once and only rebinds what changes between neighbours.
+// Programs are expected to follow fullVtx.glsl: projection, modelView and normalMatrix, plus view if the fragment stage has it.
+class RenderQueue {
+private:
+    struct ProgramEntry {
+        Shader* shader;
+        UniformHandle projection, view;
+        ObjectTransform transform;
+    };
+    std::vector<ProgramEntry> programs;
+    std::vector<Material> materials;
+    std::vector<uint32_t> materialPrograms;
+    std::unordered_map<const Mesh*, uint32_t> meshes;
+    std::vector<DrawItem> items;
+    std::vector<SortEntry> order, scratch;
+    glm::mat4 view, projection;
+    float farPlane = 100.0f;
+    RenderQueueStats last;
+
+    uint32_t programIndex(Shader* shader) {
+        for (size_t i = 0; i < programs.size(); i++)
+            if (programs[i].shader == shader) return (uint32_t)i;
+        programs.push_back({ shader, shader->uniform("projection"), shader->uniform("view"), ObjectTransform(*shader) });
+        return (uint32_t)programs.size() - 1;
+    }
+
+    uint32_t depthBucket(RenderPass pass, const glm::mat4& model) const {
+        const uint32_t maxBucket = (1u << SORT_DEPTH_BITS) - 1;
+        float depth = -(view * model[3]).z / farPlane;
+        uint32_t bucket = (uint32_t)(std::min(std::max(depth, 0.0f), 1.0f) * maxBucket);
+        return pass == RenderPass::Transparent ? maxBucket - bucket : bucket;
+    }
+public:
+    // materials and meshes get their key index on registration, keep both alive as long as the queue
+    uint32_t addMaterial(const Material& material) {
+        materials.push_back(material);
+        materialPrograms.push_back(programIndex(material.shader));
+        return (uint32_t)materials.size() - 1;
+    }
+
+    uint32_t meshIndex(const Mesh& mesh) {
+        auto it = meshes.find(&mesh);
+        if (it != meshes.end()) return it->second;
+        uint32_t index = (uint32_t)meshes.size();
+        meshes[&mesh] = index;
+        return index;
+    }
+
+    void begin(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, float far = 100.0f) {
+        items.clear();
+        view = viewMatrix;
+        projection = projectionMatrix;
+        farPlane = far;
+    }
+
+    void submit(RenderPass pass, uint32_t material, const Mesh& mesh, const glm::mat4& model, const glm::vec3& color = glm::vec3(1.0f)) {
+        uint64_t key = makeSortKey((uint32_t)pass, materialPrograms[material], material, meshIndex(mesh), depthBucket(pass, model));
+        items.push_back({ key, &mesh, material, model, color });
+    }
+
+    void sort() {
+        PROFILE_SCOPE("renderQueueSort");
+        order.resize(items.size());
+        for (size_t i = 0; i < items.size(); i++) order[i] = { items[i].key, (uint32_t)i };
+        radixSort(order, scratch);
+    }
+
+    void execute() {
+        PROFILE_SCOPE("renderQueueExecute");
+        RenderQueueStats stats;
+        uint32_t program = ~0u, material = ~0u;
+        const Mesh* mesh = nullptr;
+        UniformHandle colorLoc;
+        for (const SortEntry& entry : order) {
+            const DrawItem& item = items[entry.index];
+            const Material& mat = materials[item.material];
+            ProgramEntry& prog = programs[materialPrograms[item.material]];
+            if (materialPrograms[item.material] != program) {
+                program = materialPrograms[item.material];
+                prog.shader->use();
+                prog.shader->setMatrix(prog.projection, projection);
+                if (prog.view.valid()) prog.shader->setMatrix(prog.view, view);
+                material = ~0u;
+                stats.programChanges++;
+            }
+            if (item.material != material) {
+                material = item.material;
+                for (int unit = 0; unit < Material::MAX_TEXTURES; unit++) {
+                    if (!mat.textures[unit]) continue;
+                    mat.textures[unit]->bind(unit, GL_TEXTURE_2D);
+                    glState().bindSampler(unit, mat.samplers[unit] ? mat.samplers[unit]->id() : 0);
+                }
+                colorLoc = mat.colorUniform ? prog.shader->uniform(mat.colorUniform) : UniformHandle();
+                stats.materialChanges++;
+            }
+            if (item.mesh != mesh) {
+                mesh = item.mesh;
+                mesh->VAO.bind();
+                stats.meshChanges++;
+            }
+            prog.transform.set(*prog.shader, view, item.model);
+            if (colorLoc.valid()) prog.shader->setVec3(colorLoc, item.color);
+            mesh->draw();
+            stats.draws++;
+        }
+        last = stats;
+    }
+
+    void flush() {
+        sort();
+        execute();
+    }
+
+    size_t size() const { return items.size(); }
+    // the i-th draw of the last sort, in the order execute issues them
+    const DrawItem& sorted(size_t i) const { return items[order[i].index]; }
+    const RenderQueueStats& stats() const { return last; }
+};
+
+#endif
\ No newline at end of file
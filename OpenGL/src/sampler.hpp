@@ -0,0 +1,75 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include "glResource.hpp"
+#include "glState.hpp"
+
+// how a texture is sampled, kept apart from the image so one texture can be read several ways
+struct SamplerDesc {
+    GLenum wrapS = GL_REPEAT, wrapT = GL_REPEAT;
+    GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR, magFilter = GL_LINEAR;
+    float anisotropy = 1.0f; // clamped to what the context offers, 1 is off
+
+    SamplerDesc() = default;
+    SamplerDesc(GLenum wrap, GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR, GLenum magFilter = GL_LINEAR, float anisotropy = 1.0f)
+        : wrapS(wrap), wrapT(wrap), minFilter(minFilter), magFilter(magFilter), anisotropy(anisotropy) {}
+
+    bool operator==(const SamplerDesc& o) const {
+        return wrapS == o.wrapS && wrapT == o.wrapT && minFilter == o.minFilter && magFilter == o.magFilter && anisotropy == o.anisotropy;
+    }
+};
+
+// one sampler object per distinct SamplerDesc, created on first use and kept for the context's lifetime.
+// A program only ever needs a handful, so lookup is a linear scan.
+class SamplerCache {
+private:
+    struct Entry {
+        SamplerDesc desc;
+        Sampler sampler;
+    };
+    std::deque<Entry> entries; // deque so the references handed out stay valid as it grows
+    float maxAnisotropy = -1.0f;
+
+    // 1 without anisotropic filtering, core since 4.6 and an extension everywhere before that
+    float anisotropyLimit() {
+        if (maxAnisotropy < 0.0f) {
+            maxAnisotropy = 1.0f;
+            if (glVersionAtLeast(4, 6) || hasGLExtension("GL_ARB_texture_filter_anisotropic") || hasGLExtension("GL_EXT_texture_filter_anisotropic"))
+                glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+        }
+        return maxAnisotropy;
+    }
+public:
+    const Sampler& get(const SamplerDesc& desc) {
+        for (const Entry& entry : entries)
+            if (entry.desc == desc) return entry.sampler;
+        entries.emplace_back();
+        Entry& entry = entries.back();
+        entry.desc = desc;
+        GLuint name = entry.sampler.generate();
+        glSamplerParameteri(name, GL_TEXTURE_WRAP_S, desc.wrapS);
+        glSamplerParameteri(name, GL_TEXTURE_WRAP_T, desc.wrapT);
+        glSamplerParameteri(name, GL_TEXTURE_MIN_FILTER, desc.minFilter);
+        glSamplerParameteri(name, GL_TEXTURE_MAG_FILTER, desc.magFilter);
+        float anisotropy = std::min(desc.anisotropy, anisotropyLimit());
+        if (anisotropy > 1.0f) glSamplerParameterf(name, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+        return entry.sampler;
+    }
+
+    size_t size() const { return entries.size(); }
+
+    // objects die with the context, this just lets go of the names
+    void clear() { entries.clear(); }
+};
+
+// never destroyed, like glResources
+SamplerCache& samplerCache() {
+    static SamplerCache* cache = new SamplerCache();
+    return *cache;
+}
+
+#endif
\ No newline at end of file
@@ -1,12 +1,27 @@
+#ifndef SAMPLES_H
+#define SAMPLES_H
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "models.hpp"
+#include "mesh.hpp"
+#include "quantize.hpp"
 #include "shader.hpp"
 #include "texture.hpp"
 #include "camera.hpp"
+#include "lightBlock.hpp"
+#include "instancing.hpp"
+#include "transform.hpp"
+#include "renderQueue.hpp"
+#include "multiDraw.hpp"
+#include "meshArena.hpp"
+#include "culling.hpp"
+#include "bvh.hpp"
+#include "jobs.hpp"
+#include "textureCache.hpp"
 
 const glm::vec3 cubePositions[] = {
     glm::vec3( 0.0f,  0.0f,  0.0f), 
@@ -35,13 +50,40 @@ glm::vec3 pointLightColors[] = {
     glm::vec3(0.3f, 0.1f, 0.1f)
 };
 
+// shared by every program lit through LightBlock
+LightBuffer partyLights;
+// diffuse, specular and emission maps of the party cubes, bound to units 0-2
+TextureHandle partyMaps[3];
+// set by --cooked-textures, the party maps come from textureCooker's .dds files wherever those exist
+bool partyCookedMaps = false;
+// how every party map is sampled, trilinear plus whatever --anisotropy asks for
+float partyAnisotropy = 1.0f;
+const Sampler* partySampler = nullptr;
+
 glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 glm::vec3 lightDir(-0.2f, -1.0f, -0.3f);
 
-void drawParty(Camera& cam, unsigned int VAO, Shader& lightingShader, bool lightAtCam = false) {
-    glBindVertexArray(VAO);
+// the first ten cubes are the classic party, any extra ones are scattered deterministically in front of the camera
+glm::vec3 partyPosition(unsigned int i) {
+    if (i < 10) return cubePositions[i];
+    unsigned int h = i * 2654435761u;
+    float x = (h & 0x3FF) / 1023.0f, y = ((h >> 10) & 0x3FF) / 1023.0f, z = ((h >> 20) & 0x3FF) / 1023.0f;
+    return glm::vec3((x - 0.5f) * 80.0f, (y - 0.5f) * 60.0f, -5.0f - z * 85.0f);
+}
+
+glm::mat4 partyModel(unsigned int i, float time) {
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, partyPosition(i));
+    float angle = 20.0f * i;
+    model = glm::rotate(model, (i % 3 == 0 ? time : 0.0f) * glm::radians(60.0f) + glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+    return model;
+}
+
+void drawParty(Camera& cam, const Mesh& mesh, Shader& lightingShader, bool lightAtCam = false, unsigned int count = 10) {
+    mesh.VAO.bind();
     lightingShader.use();
-    lightingShader.setMatrix("view", cam.getViewMatrix());
+    glm::mat4 view = cam.getViewMatrix();
+    lightingShader.setMatrix("view", view);
     lightingShader.setMatrix("projection", glm::perspective(glm::radians(cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f));
     if (lightAtCam) {
         lightingShader.setBool("light.atCam", true);
@@ -50,140 +92,411 @@ void drawParty(Camera& cam, unsigned int VAO, Shader& lightingShader, bool light
         lightingShader.setVec3("light.position", lightPos);
         lightingShader.setVec3("light.direction", lightDir);
     }
-    for (unsigned int i = 0; i < 10; i++) {
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, cubePositions[i]);
-        float angle = 20.0f * i;
-        model = glm::rotate(model, (i % 3 == 0 ? (float)glfwGetTime() : 0.0f) * glm::radians(60.0f) + glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-        lightingShader.setMatrix("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+    ObjectTransform transform(lightingShader);
+    float time = (float)glfwGetTime();
+    for (unsigned int i = 0; i < count; i++) {
+        transform.set(lightingShader, view, partyModel(i, time));
+        mesh.draw();
     }
 }
 
-void drawPartyCL(Camera& cam, unsigned int VAO, Shader& lightingShader) {
-    glBindVertexArray(VAO);
+void bindPartyMaps();
+
+// rebind sets program, VAO and maps again before every cube, the way code without a state cache tends to
+void drawPartyCL(Camera& cam, const Mesh& mesh, Shader& lightingShader, unsigned int count = 10, bool rebind = false) {
+    PROFILE_SCOPE("drawPartyCL");
+    partyLights.sync();
+    mesh.VAO.bind();
     lightingShader.use();
-    lightingShader.setMatrix("view", cam.getViewMatrix());
+    glm::mat4 view = cam.getViewMatrix();
+    lightingShader.setMatrix("view", view);
     lightingShader.setMatrix("projection", glm::perspective(glm::radians(cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f));
-    for (unsigned int i = 0; i < 10; i++) {
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, cubePositions[i]);
-        float angle = 20.0f * i;
-        model = glm::rotate(model, (i % 3 == 0 ? (float)glfwGetTime() : 0.0f) * glm::radians(60.0f) + glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-        lightingShader.setMatrix("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+    ObjectTransform transform(lightingShader);
+    float time = (float)glfwGetTime();
+    for (unsigned int i = 0; i < count; i++) {
+        if (rebind) {
+            lightingShader.use();
+            mesh.VAO.bind();
+            bindPartyMaps();
+        }
+        transform.set(lightingShader, view, partyModel(i, time));
+        mesh.draw();
     }
 }
 
-void drawLight(Camera& cam, unsigned int VAO, Shader& lightSrcShader) {
-    glBindVertexArray(VAO);
+// the cubes only ever spin about their centre, so a sphere around the unit cube bounds them for good
+SphereSoA partyBounds(unsigned int count) {
+    SphereSoA bounds;
+    for (unsigned int i = 0; i < count; i++) bounds.add(partyPosition(i), 0.8660254f);
+    return bounds;
+}
+
+// drawPartyCL over the cubes left after frustum culling, visible is kept by the caller so it is allocated once
+void drawPartyCulled(Camera& cam, const Mesh& mesh, Shader& lightingShader, const SphereSoA& bounds, std::vector<uint32_t>& visible) {
+    PROFILE_SCOPE("drawPartyCulled");
+    partyLights.sync();
+    glm::mat4 view = cam.getViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f);
+    size_t count;
+    {
+        PROFILE_SCOPE("frustumCull");
+        count = cullSpheres(extractFrustum(projection, view), bounds, visible);
+    }
+    mesh.VAO.bind();
+    lightingShader.use();
+    lightingShader.setMatrix("view", view);
+    lightingShader.setMatrix("projection", projection);
+    ObjectTransform transform(lightingShader);
+    float time = (float)glfwGetTime();
+    for (size_t i = 0; i < count; i++) {
+        transform.set(lightingShader, view, partyModel(visible[i], time));
+        mesh.draw();
+    }
+}
+
+// what the GL thread needs for one visible cube
+struct PartyDraw {
+    glm::mat4 modelView;
+    glm::mat3 normal;
+};
+
+// cubes per job, chunk c culls into visible from c * (PARTY_CHUNK + 8) and writes its draws from c * PARTY_CHUNK,
+// so the draws come out in the order of the serial path whichever thread ran which chunk
+const size_t PARTY_CHUNK = 4096;
+
+struct PartyFrame {
+    std::vector<uint32_t> visible, counts;
+    std::vector<PartyDraw> draws;
+};
+
+// frustum culling, model matrices and the per draw matrices of every chunk on the job system
+void buildPartyDraws(JobSystem& jobs, const Frustum& frustum, const SphereSoA& bounds, const glm::mat4& view, float time, PartyFrame& frame) {
+    size_t count = bounds.size(), chunks = (count + PARTY_CHUNK - 1) / PARTY_CHUNK;
+    frame.visible.resize(chunks * (PARTY_CHUNK + 8));
+    frame.draws.resize(count);
+    frame.counts.assign(chunks, 0);
+    jobs.parallelFor(chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            size_t begin = c * PARTY_CHUNK, end = std::min(count, begin + PARTY_CHUNK);
+            uint32_t* visible = &frame.visible[c * (PARTY_CHUNK + 8)];
+            size_t n = cullSphereRange(frustum, bounds, begin, end, visible);
+            PartyDraw* draws = &frame.draws[begin];
+            for (size_t i = 0; i < n; i++) {
+                glm::mat4 mv = view * partyModel(visible[i], time);
+                draws[i] = { mv, normalMatrix(mv) };
+            }
+            frame.counts[c] = (uint32_t)n;
+        }
+    }, "partyChunk");
+}
+
+// drawPartyCulled with everything but the GL calls spread over jobs
+void drawPartyParallel(Camera& cam, const Mesh& mesh, Shader& lightingShader, const SphereSoA& bounds, JobSystem& jobs, PartyFrame& frame) {
+    PROFILE_SCOPE("drawPartyParallel");
+    partyLights.sync();
+    glm::mat4 view = cam.getViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f);
+    {
+        PROFILE_SCOPE("buildPartyDraws");
+        buildPartyDraws(jobs, extractFrustum(projection, view), bounds, view, (float)glfwGetTime(), frame);
+    }
+    mesh.VAO.bind();
+    lightingShader.use();
+    lightingShader.setMatrix("view", view);
+    lightingShader.setMatrix("projection", projection);
+    ObjectTransform transform(lightingShader);
+    for (size_t c = 0; c < frame.counts.size(); c++) {
+        const PartyDraw* draws = &frame.draws[c * PARTY_CHUNK];
+        for (uint32_t i = 0; i < frame.counts[c]; i++) {
+            transform.setModelView(lightingShader, draws[i].modelView, draws[i].normal);
+            mesh.draw();
+        }
+    }
+}
+
+const Aabb UNIT_CUBE = { glm::vec3(-0.5f), glm::vec3(0.5f) };
+
+Bvh buildPartyBvh(unsigned int count) {
+    std::vector<Aabb> bounds(count);
+    float time = (float)glfwGetTime();
+    for (unsigned int i = 0; i < count; i++) bounds[i] = transformAabb(UNIT_CUBE, partyModel(i, time));
+    Bvh bvh;
+    bvh.build(bounds);
+    return bvh;
+}
+
+// drawPartyCulled through a BVH, refit every frame for the cubes that rotate
+void drawPartyBvh(Camera& cam, const Mesh& mesh, Shader& lightingShader, Bvh& bvh, std::vector<uint32_t>& visible) {
+    PROFILE_SCOPE("drawPartyBvh");
+    partyLights.sync();
+    glm::mat4 view = cam.getViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f);
+    float time = (float)glfwGetTime();
+    {
+        PROFILE_SCOPE("bvhRefitCull");
+        for (uint32_t i = 0; i < bvh.objectCount(); i += 3) bvh.update(i, transformAabb(UNIT_CUBE, partyModel(i, time)));
+        bvh.refit();
+        bvh.cullFrustum(extractFrustum(projection, view), visible);
+    }
+    mesh.VAO.bind();
+    lightingShader.use();
+    lightingShader.setMatrix("view", view);
+    lightingShader.setMatrix("projection", projection);
+    ObjectTransform transform(lightingShader);
+    for (uint32_t i : visible) {
+        transform.set(lightingShader, view, partyModel(i, time));
+        mesh.draw();
+    }
+}
+
+// party cube under the crosshair or -1, the BVH finds candidates by their world bounds and the ray is then
+// tested against the rotated cube itself in its object space
+int pickParty(Camera& cam, const Bvh& bvh, float& distance) {
+    glm::mat4 projection = glm::perspective(glm::radians(cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f);
+    Ray ray = screenRay(projection, cam.getViewMatrix(), 0.0f, 0.0f);
+    float time = (float)glfwGetTime();
+    return bvh.raycast(ray, distance, [&](uint32_t i, float) {
+        glm::mat4 toObject = glm::inverse(partyModel(i, time));
+        Ray local(glm::vec3(toObject * glm::vec4(ray.origin, 1.0f)), glm::vec3(toObject * glm::vec4(ray.dir, 0.0f)));
+        return intersectAabb(local, UNIT_CUBE.min, UNIT_CUBE.max, FLT_MAX); // the models are rigid, distances carry over
+    });
+}
+
+// same scene as drawPartyCL but every cube goes out in a single instanced draw
+void drawPartyCLInstanced(Camera& cam, const Mesh& mesh, Shader& instancedShader, InstanceBuffer& instances, unsigned int count = 10) {
+    PROFILE_SCOPE("drawPartyCLInstanced");
+    partyLights.sync();
+    float time = (float)glfwGetTime();
+    instances.instances.resize(count);
+    for (unsigned int i = 0; i < count; i++) instances.instances[i] = makeInstance(partyModel(i, time));
+    instances.upload();
+    mesh.VAO.bind();
+    instancedShader.use();
+    instancedShader.setMatrix("view", cam.getViewMatrix());
+    instancedShader.setMatrix("projection", glm::perspective(glm::radians(cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f));
+    mesh.drawInstanced(instances.count());
+}
+
+// same scene with every cube a draw of one IndirectBatch, only the rotating ones are rewritten each frame
+void drawPartyIndirect(Camera& cam, IndirectBatch& batch, Shader& shader) {
+    PROFILE_SCOPE("drawPartyIndirect");
+    partyLights.sync();
+    float time = (float)glfwGetTime();
+    for (uint32_t i = 0; i < batch.drawCount(); i += 3) batch.setModel(i, partyModel(i, time));
+    shader.use();
+    glm::mat4 view = cam.getViewMatrix();
+    shader.setMatrix("view", view);
+    shader.setMatrix("projection", glm::perspective(glm::radians(cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f));
+    batch.draw(shader, view);
+}
+
+// drawPartyCL with the cube sub-allocated from a MeshArena instead of its own VAO
+void drawPartyArena(Camera& cam, const MeshArena& arena, uint32_t cube, Shader& lightingShader, unsigned int count = 10) {
+    PROFILE_SCOPE("drawPartyArena");
+    partyLights.sync();
+    arena.bind(cube);
+    lightingShader.use();
+    glm::mat4 view = cam.getViewMatrix();
+    lightingShader.setMatrix("view", view);
+    lightingShader.setMatrix("projection", glm::perspective(glm::radians(cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f));
+    ObjectTransform transform(lightingShader);
+    float time = (float)glfwGetTime();
+    for (unsigned int i = 0; i < count; i++) {
+        transform.set(lightingShader, view, partyModel(i, time));
+        arena.draw(cube);
+    }
+}
+
+glm::mat4 staticLightModel() {
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, lightPos);
+    model = glm::scale(model, glm::vec3(0.2f));
+    return model;
+}
+
+void drawLight(Camera& cam, const Mesh& mesh, Shader& lightSrcShader) {
+    mesh.VAO.bind();
     lightSrcShader.use();
-    lightSrcShader.setMatrix("view", cam.getViewMatrix());
+    ObjectTransform(lightSrcShader).set(lightSrcShader, cam.getViewMatrix(), staticLightModel());
     lightSrcShader.setMatrix("projection", glm::perspective(glm::radians(cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f));
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    mesh.draw();
 }
 
-void drawPtLights(Camera& cam, unsigned int VAO, Shader& lightSrcShader) {
-    glBindVertexArray(VAO);
+void drawPtLights(Camera& cam, const Mesh& mesh, Shader& lightSrcShader) {
+    PROFILE_SCOPE("drawPtLights");
+    mesh.VAO.bind();
     lightSrcShader.use();
-    lightSrcShader.setMatrix("view", cam.getViewMatrix());
+    glm::mat4 view = cam.getViewMatrix();
     lightSrcShader.setMatrix("projection", glm::perspective(glm::radians(cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f));
+    ObjectTransform transform(lightSrcShader);
+    UniformHandle colorLoc = lightSrcShader.uniform("lightColor");
+    for (int i = 0; i < 4; i++) {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, pointLightPositions[i]);
+        model = glm::scale(model, glm::vec3(0.2f));
+        lightSrcShader.setVec3(colorLoc, pointLightColors[i]);
+        transform.set(lightSrcShader, view, model);
+        mesh.draw();
+    }
+}
+
+// party scene through a RenderQueue, the cubes are one textured material and the point lights one unlit material
+struct PartyMaterials {
+    uint32_t cube, light;
+};
+
+PartyMaterials addPartyMaterials(RenderQueue& queue, Shader& lightingShader, Shader& lightSrcShader) {
+    Material cube, light;
+    cube.shader = &lightingShader;
+    for (int i = 0; i < 3; i++) {
+        cube.textures[i] = partyMaps[i].get();
+        cube.samplers[i] = partySampler;
+    }
+    light.shader = &lightSrcShader;
+    light.colorUniform = "lightColor";
+    return { queue.addMaterial(cube), queue.addMaterial(light) };
+}
+
+void submitPtLights(RenderQueue& queue, uint32_t material, const Mesh& mesh) {
     for (int i = 0; i < 4; i++) {
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, pointLightPositions[i]);
         model = glm::scale(model, glm::vec3(0.2f));
-        lightSrcShader.setVec3("lightColor", pointLightColors[i]);
-        lightSrcShader.setMatrix("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        queue.submit(RenderPass::Unlit, material, mesh, model, pointLightColors[i]);
     }
 }
 
+void submitPartyCL(RenderQueue& queue, uint32_t material, const Mesh& mesh, unsigned int count = 10) {
+    float time = (float)glfwGetTime();
+    for (unsigned int i = 0; i < count; i++) queue.submit(RenderPass::Opaque, material, mesh, partyModel(i, time));
+}
+
+void drawPartyQueued(Camera& cam, RenderQueue& queue, const PartyMaterials& materials, const Mesh& lightMesh, const Mesh& cube, unsigned int count = 10) {
+    partyLights.sync();
+    queue.begin(cam.getViewMatrix(), glm::perspective(glm::radians(cam.getFov()), 800.0f / 600.0f, 0.1f, 100.0f));
+    submitPtLights(queue, materials.light, lightMesh);
+    submitPartyCL(queue, materials.cube, cube, count);
+    queue.flush();
+}
+
 Shader prepStaticLightSrc() {
     Shader lightSrcShader("../src/shaders/fullVtx.glsl", "../src/shaders/lightSrc.glsl");
     lightSrcShader.use();
     lightSrcShader.setVec3("lightColor", glm::vec3(1.0));
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, lightPos);
-    model = glm::scale(model, glm::vec3(0.2f));
-    lightSrcShader.setMatrix("model", model);
     return lightSrcShader;
 }
 
-std::pair<Shader, std::vector<unsigned int>> prepPartyCL() {
-    Shader lightingShader("../src/shaders/fullVtx.glsl", "../src/shaders/lightTypes/combined.glsl");
+// decode uniforms of fullVtxQuantized.glsl, constant per mesh so set once rather than per draw
+void setVertexDecode(const Shader& shader, const VertexDecode& decode) {
+    shader.setVec3("posOffset", glm::make_vec3(decode.posOffset));
+    shader.setVec3("posScale", glm::make_vec3(decode.posScale));
+    shader.setVec2("uvOffset", glm::make_vec2(decode.uvOffset));
+    shader.setVec2("uvScale", glm::make_vec2(decode.uvScale));
+}
+
+// shared through textureCache() by every party sample, streamed ones show grey diffuse with no specular or emission until they are in
+void loadPartyMaps() {
+    const glm::vec4 black(0.0f, 0.0f, 0.0f, 1.0f);
+    const char* paths[3] = { "../public/container2.png", "../public/lighting_maps_specular_color.png", "../public/matrix.jpg" };
+    for (int i = 0; i < 3; i++) {
+        std::string path = partyCookedMaps ? cookedTexturePath(paths[i]) : paths[i];
+        partyMaps[i] = textureCache().acquire(path.c_str(), TextureOptions(), i == 0 ? glm::vec4(0.5f, 0.5f, 0.5f, 1.0f) : black);
+    }
+    partySampler = &samplerCache().get(SamplerDesc(GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, partyAnisotropy));
+}
+
+// expects loadPartyMaps to have run
+void bindPartyMaps() {
+    for (int i = 0; i < 3; i++) {
+        partyMaps[i].bind(i, GL_TEXTURE_2D);
+        partySampler->bind(i);
+    }
+}
+
+// quantize draws a 16 byte per vertex cube through fullVtxQuantized.glsl instead
+std::pair<Shader, Mesh> prepPartyCL(bool quantize = false) {
+    Shader lightingShader(quantize ? "../src/shaders/fullVtxQuantized.glsl" : "../src/shaders/fullVtx.glsl",
+                          "../src/shaders/lightTypes/combined.glsl");
     lightingShader.use();
+    partyLights.init();
+    partyLights.attach(lightingShader);
+    LightBlock& lights = partyLights.edit();
     // Directional light
-    lightingShader.setVec3("dirLight.direction", glm::vec3(-0.2f, -1.0f, -0.3f));		
-    lightingShader.setVec3("dirLight.ambient", glm::vec3(0.0f, 0.0f, 0.0f));	
-    lightingShader.setVec3("dirLight.diffuse", glm::vec3(0.05f, 0.05f, 0.05)); 
-    lightingShader.setVec3("dirLight.specular", glm::vec3(0.2f, 0.2f, 0.2f));
-    // Point light 1
-    lightingShader.setVec3("pointLights[0].position", pointLightPositions[0]);		
-    lightingShader.setVec3("pointLights[0].ambient", glm::vec3(0.1) * pointLightColors[0]);		
-    lightingShader.setVec3("pointLights[0].diffuse", pointLightColors[0]); 
-    lightingShader.setVec3("pointLights[0].specular", pointLightColors[0]);
-    lightingShader.setFloat("pointLights[0].constant", 1.0f);
-    lightingShader.setFloat("pointLights[0].linear", 0.14);
-    lightingShader.setFloat("pointLights[0].quadratic", 0.07);		
-    // Point light 2
-    lightingShader.setVec3("pointLights[1].position", pointLightPositions[1]);		
-    lightingShader.setVec3("pointLights[1].ambient", glm::vec3(0.1) * pointLightColors[1]);		
-    lightingShader.setVec3("pointLights[1].diffuse", pointLightColors[1]); 
-    lightingShader.setVec3("pointLights[1].specular", pointLightColors[1]);
-    lightingShader.setFloat("pointLights[1].constant", 1.0f);
-    lightingShader.setFloat("pointLights[1].linear", 0.14);
-    lightingShader.setFloat("pointLights[1].quadratic", 0.07);		
-    // Point light 3
-    lightingShader.setVec3("pointLights[2].position", pointLightPositions[2]);		
-    lightingShader.setVec3("pointLights[2].ambient",  glm::vec3(0.1) * pointLightColors[2]);		
-    lightingShader.setVec3("pointLights[2].diffuse", pointLightColors[2]); 
-    lightingShader.setVec3("pointLights[2].specular" ,pointLightColors[2]);
-    lightingShader.setFloat("pointLights[2].constant", 1.0f);
-    lightingShader.setFloat("pointLights[2].linear", 0.22);
-    lightingShader.setFloat("pointLights[2].quadratic", 0.20);		
-    // Point light 4
-    lightingShader.setVec3("pointLights[3].position", pointLightPositions[3]);		
-    lightingShader.setVec3("pointLights[3].ambient",  glm::vec3(0.1) * pointLightColors[3]);		
-    lightingShader.setVec3("pointLights[3].diffuse", pointLightColors[3]); 
-    lightingShader.setVec3("pointLights[3].specular", pointLightColors[3]);
-    lightingShader.setFloat("pointLights[3].constant", 1.0f);
-    lightingShader.setFloat("pointLights[3].linear", 0.14);
-    lightingShader.setFloat("pointLights[3].quadratic", 0.07);		
+    lights.dirLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    lights.dirLight.ambient = glm::vec3(0.0f, 0.0f, 0.0f);
+    lights.dirLight.diffuse = glm::vec3(0.05f, 0.05f, 0.05);
+    lights.dirLight.specular = glm::vec3(0.2f, 0.2f, 0.2f);
+    // Point lights
+    const float linear[] = { 0.14f, 0.14f, 0.22f, 0.14f }, quadratic[] = { 0.07f, 0.07f, 0.20f, 0.07f };
+    for (int i = 0; i < NR_POINT_LIGHTS; i++) {
+        lights.pointLights[i].position = pointLightPositions[i];
+        lights.pointLights[i].ambient = glm::vec3(0.1) * pointLightColors[i];
+        lights.pointLights[i].diffuse = pointLightColors[i];
+        lights.pointLights[i].specular = pointLightColors[i];
+        lights.pointLights[i].constant = 1.0f;
+        lights.pointLights[i].linear = linear[i];
+        lights.pointLights[i].quadratic = quadratic[i];
+    }
     // flashLight
-    lightingShader.setVec3("flashLight.ambient", glm::vec3(0.0f, 0.0f, 0.0f));	
-    lightingShader.setVec3("flashLight.diffuse", glm::vec3(1.0f, 1.0f, 1.0f)); 
-    lightingShader.setVec3("flashLight.specular", glm::vec3(1.0f, 1.0f, 1.0f));
-    lightingShader.setFloat("flashLight.constant", 1.0f);
-    lightingShader.setFloat("flashLight.linear", 0.09);
-    lightingShader.setFloat("flashLight.quadratic", 0.032);			
-    lightingShader.setFloat("flashLight.innerCone", glm::cos(glm::radians(10.0f)));
-    lightingShader.setFloat("flashLight.outerCone", glm::cos(glm::radians(15.0f)));
+    lights.flashLight.ambient = glm::vec3(0.0f, 0.0f, 0.0f);
+    lights.flashLight.diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+    lights.flashLight.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+    lights.flashLight.constant = 1.0f;
+    lights.flashLight.linear = 0.09;
+    lights.flashLight.quadratic = 0.032;
+    lights.flashLight.innerCone = glm::cos(glm::radians(10.0f));
+    lights.flashLight.outerCone = glm::cos(glm::radians(15.0f));
+    partyLights.sync();
 
     lightingShader.setVec3("material.ambient", glm::vec3(1.0f, 0.5f, 0.31f));
     lightingShader.setVec3("material.diffuse", glm::vec3(1.0f, 0.5f, 0.31f));
     lightingShader.setVec3("material.specular", glm::vec3(0.5f, 0.5f, 0.5f));
     lightingShader.setFloat("material.shininess", 32.0f);
 
-    unsigned int diffuseMap = loadTexture("../public/container2.png");
-    unsigned int specMap = loadTexture("../public/lighting_maps_specular_color.png");
-    unsigned int emissionMap = loadTexture("../public/matrix.jpg");
+    loadPartyMaps();
     lightingShader.setInt("material.diffuse", 0);
     lightingShader.setInt("material.specular", 1);
     lightingShader.setInt("material.emission", 2);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, diffuseMap);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, specMap);
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, emissionMap);
+    bindPartyMaps();
+
+    Mesh cube = quantize ? createQuantizedCubeWithNormTex() : createIndexedCubeWithNormTex();
+    if (quantize) setVertexDecode(lightingShader, cube.decode);
+    return std::make_pair(std::move(lightingShader), std::move(cube));
+}
+
+// expects prepPartyCL to have run, it reuses the textures and LightBlock it set up
+std::pair<Shader, Mesh> prepPartyCLInstanced(InstanceBuffer& instances) {
+    Shader instancedShader("../src/shaders/fullVtxInstanced.glsl", "../src/shaders/lightTypes/combined.glsl");
+    instancedShader.use();
+    partyLights.attach(instancedShader);
+    instancedShader.setFloat("material.shininess", 32.0f);
+    instancedShader.setInt("material.diffuse", 0);
+    instancedShader.setInt("material.specular", 1);
+    instancedShader.setInt("material.emission", 2);
 
-    auto cube = createCubeWithNormTex();
-    unsigned int cubeVAO = cube.second, cubeVtxCount = cube.first;
-    std::vector<unsigned int> handles = { cubeVAO, cubeVtxCount };
-    return std::make_pair(lightingShader, handles);
+    // own VAO so the per-instance attributes never leak into the non-instanced cube draws
+    Mesh cube = createIndexedCubeWithNormTex();
+    instances.attach(cube.VAO.id());
+    return std::make_pair(std::move(instancedShader), std::move(cube));
 }
 
-std::pair<Shader, std::vector<unsigned int>> prepParty(std::string lightType) {
+// expects prepPartyCL to have run like prepPartyCLInstanced, the shader follows the path the batch will take
+std::pair<Shader, IndirectBatch> prepPartyIndirect(unsigned int count = 10) {
+    IndirectBatch batch;
+    uint32_t cube = batch.addObj(defCubeWithNormTex, sizeof(defCubeWithNormTex));
+    for (unsigned int i = 0; i < count; i++) batch.addDraw(cube, partyModel(i, 0.0f));
+    Shader shader(batch.indirect ? "../src/shaders/fullVtxIndirect.glsl" : "../src/shaders/fullVtx.glsl", "../src/shaders/lightTypes/combined.glsl");
+    shader.use();
+    partyLights.attach(shader);
+    shader.setFloat("material.shininess", 32.0f);
+    shader.setInt("material.diffuse", 0);
+    shader.setInt("material.specular", 1);
+    shader.setInt("material.emission", 2);
+    std::cout << "party cubes drawn " << (batch.indirect ? "with glMultiDrawElementsIndirect" : "in a glDrawElementsBaseVertex loop") << std::endl;
+    return std::make_pair(std::move(shader), std::move(batch));
+}
+
+std::pair<Shader, Mesh> prepParty(std::string lightType) {
     Shader lightingShader("../src/shaders/fullVtx.glsl", ("../src/shaders/lightTypes/" + lightType + ".glsl").c_str());
 
     lightingShader.use();
@@ -209,21 +522,13 @@ std::pair<Shader, std::vector<unsigned int>> prepParty(std::string lightType) {
     lightingShader.setVec3("light.diffuse", glm::vec3(0.8f, 0.8f, 0.8f));
     lightingShader.setVec3("light.specular", glm::vec3(1.0f, 1.0f, 1.0f));
     // lightingShader.setMatrix("model", glm::mat4(1.0f));
-    unsigned int diffuseMap = loadTexture("../public/container2.png");
-    unsigned int specMap = loadTexture("../public/lighting_maps_specular_color.png");
-    unsigned int emissionMap = loadTexture("../public/matrix.jpg");
+    loadPartyMaps();
     lightingShader.setInt("material.diffuse", 0);
     lightingShader.setInt("material.specular", 1);
     lightingShader.setInt("material.emission", 2);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, diffuseMap);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, specMap);
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, emissionMap);
-
-    auto cube = createCubeWithNormTex();
-    unsigned int cubeVAO = cube.second, cubeVtxCount = cube.first;
-    std::vector<unsigned int> handles = { cubeVAO, cubeVtxCount };
-    return std::make_pair(lightingShader, handles);
-}
\ No newline at end of file
+    bindPartyMaps();
+
+    return std::make_pair(std::move(lightingShader), createIndexedCubeWithNormTex());
+}
+
+#endif
\ No newline at end of file
@@ -6,16 +6,96 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "glResource.hpp"
+#include "profiler.hpp"
+
+// pre-resolved uniform location, fetch once with Shader::uniform and reuse every draw
+struct UniformHandle {
+    GLint location = -1;
+    bool valid() const { return location >= 0; }
+};
 
 class Shader
 {
+private:
+    struct UniformEntry {
+        std::string name;
+        GLint location;
+        GLenum type;
+    };
+    // flat table of active uniforms, indexed by an open addressing hash of the name
+    std::vector<UniformEntry> uniforms;
+    std::vector<int> uniformSlots;
+
+    static uint32_t hashName(const char* name) {
+        uint32_t h = 2166136261u; // FNV-1a
+        for (; *name; ++name) h = (h ^ (unsigned char)*name) * 16777619u;
+        return h;
+    }
+
+    void insertUniform(const std::string& name, GLint location, GLenum type) {
+        uniforms.push_back({ name, location, type });
+        uint32_t mask = (uint32_t)uniformSlots.size() - 1;
+        uint32_t slot = hashName(name.c_str()) & mask;
+        while (uniformSlots[slot] != -1) slot = (slot + 1) & mask;
+        uniformSlots[slot] = (int)uniforms.size() - 1;
+    }
+
+    // reflect every active uniform once after link so lookups never reach the driver
+    void reflectUniforms() {
+        GLint count = 0, maxLen = 0;
+        glGetProgramiv(id(), GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(id(), GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLen);
+        // arrays of basic types expose a single entry, reserve room for their expanded elements
+        std::vector<std::string> names(count);
+        std::vector<GLint> sizes(count);
+        std::vector<GLenum> types(count);
+        std::vector<char> buf(maxLen > 0 ? maxLen : 1);
+        size_t total = 0;
+        for (GLint i = 0; i < count; i++) {
+            GLsizei len = 0;
+            glGetActiveUniform(id(), i, (GLsizei)buf.size(), &len, &sizes[i], &types[i], buf.data());
+            names[i].assign(buf.data(), len);
+            total += sizes[i] > 1 ? sizes[i] + 1 : 1;
+        }
+        size_t cap = 16;
+        while (cap < total * 2) cap <<= 1;
+        uniforms.clear();
+        uniforms.reserve(total);
+        uniformSlots.assign(cap, -1);
+        for (GLint i = 0; i < count; i++) {
+            GLint location = glGetUniformLocation(id(), names[i].c_str());
+            if (location < 0) continue; // uniform block members have no location
+            if (sizes[i] > 1 && names[i].size() > 3 && names[i].compare(names[i].size() - 3, 3, "[0]") == 0) {
+                std::string base = names[i].substr(0, names[i].size() - 3);
+                insertUniform(base, location, types[i]);
+                for (GLint e = 0; e < sizes[i]; e++)
+                    insertUniform(base + "[" + std::to_string(e) + "]", glGetUniformLocation(id(), (base + "[" + std::to_string(e) + "]").c_str()), types[i]);
+            } else insertUniform(names[i], location, types[i]);
+        }
+    }
+
+    GLint location(const char* name) const {
+        if (!uniformCacheEnabled || uniformSlots.empty()) return glGetUniformLocation(id(), name);
+        uint32_t mask = (uint32_t)uniformSlots.size() - 1;
+        for (uint32_t slot = hashName(name) & mask; uniformSlots[slot] != -1; slot = (slot + 1) & mask) {
+            const UniformEntry& entry = uniforms[uniformSlots[slot]];
+            if (entry.name == name) return entry.location;
+        }
+        return -1;
+    }
 public:
-    // the program ID
-    unsigned int ID;
+    // the program, deleted with the Shader, which makes Shader move-only
+    Program program;
+    // when false every lookup goes back to glGetUniformLocation, only useful for benchmarking
+    static bool uniformCacheEnabled;
 
+    Shader() = default;
     // constructor reads and builds the shader
     Shader(const char* vertexPath, const char* fragmentPath) {
             // 1. retrieve the vertex/fragment source code from filePath
@@ -50,6 +130,7 @@ public:
         const char* fShaderCode = fragmentCode.c_str();
 
                 // 2. compile shaders
+        PROFILE_SCOPE("compileShader");
         unsigned int vertex, fragment;
         int success;
         char infoLog[512];
@@ -77,7 +158,7 @@ public:
 
 
         // shader Program
-        ID = glCreateProgram();
+        GLuint ID = program.generate();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
         glLinkProgram(ID);
@@ -92,24 +173,40 @@ public:
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
+
+        reflectUniforms();
     }
     // use/activate the shader
-    void use() { glUseProgram(ID); }
-    void setBool(const std::string &name, bool value) const {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    void use() const { program.use(); }
+    unsigned int id() const { return program.id(); }
+    UniformHandle uniform(const std::string &name) const { return { location(name.c_str()) }; }
+    size_t uniformCount() const { return uniforms.size(); }
+
+    void setBool(const std::string &name, bool value) const { setBool(uniform(name), value); }
+    void setInt(const std::string &name, int value) const { setInt(uniform(name), value); }
+    void setFloat(const std::string &name, float value) const { setFloat(uniform(name), value); }
+    void setMatrix(const std::string &name, const glm::mat4 &value) const { setMatrix(uniform(name), value); }
+    void setMat3(const std::string &name, const glm::mat3 &value) const { setMat3(uniform(name), value); }
+    void setVec2(const std::string &name, const glm::vec2 &value) const { setVec2(uniform(name), value); }
+    void setVec3(const std::string &name, const glm::vec3 &value) const { setVec3(uniform(name), value); }
+
+    void setBool(UniformHandle h, bool value) const { glUniform1i(h.location, (int)value); }
+    void setInt(UniformHandle h, int value) const { glUniform1i(h.location, value); }
+    void setFloat(UniformHandle h, float value) const { glUniform1f(h.location, value); }
+    void setMatrix(UniformHandle h, const glm::mat4 &value) const {
+        glUniformMatrix4fv(h.location, 1, GL_FALSE, glm::value_ptr(value));
     }
-    void setInt(const std::string &name, int value) const { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    void setMat3(UniformHandle h, const glm::mat3 &value) const {
+        glUniformMatrix3fv(h.location, 1, GL_FALSE, glm::value_ptr(value));
     }
-    void setFloat(const std::string &name, float value) const { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
-    } 
-    void setMatrix(const std::string &name, glm::mat4 value) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    void setVec2(UniformHandle h, const glm::vec2 &value) const {
+        glUniform2fv(h.location, 1, glm::value_ptr(value));
     }
-    void setVec3(const std::string &name, glm::vec3 value) const {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+    void setVec3(UniformHandle h, const glm::vec3 &value) const {
+        glUniform3fv(h.location, 1, glm::value_ptr(value));
     }
 };
 
+bool Shader::uniformCacheEnabled = true;
+
 #endif
\ No newline at end of file
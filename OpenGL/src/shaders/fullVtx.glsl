@@ -3,8 +3,8 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
-uniform mat4 model;
-uniform mat4 view;
+uniform mat4 modelView;
+uniform mat3 normalMatrix; // inverse transpose of modelView, computed once per object on the CPU
 uniform mat4 projection;
 
 out vec3 FragPos;
@@ -13,8 +13,9 @@ out vec2 TexCoords;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    FragPos = vec3(view * model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(view * model))) * aNormal;
+    vec4 viewPos = modelView * vec4(aPos, 1.0);
+    gl_Position = projection * viewPos;
+    FragPos = vec3(viewPos);
+    Normal = normalMatrix * aNormal;
     TexCoords = aTexCoords;
 } 
\ No newline at end of file
@@ -0,0 +1,32 @@
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+// one entry per draw, IndirectDrawData on the CPU side
+struct DrawData {
+    mat4 model;
+    mat3 normalMatrix;
+};
+
+layout (std430, binding = 0) readonly buffer DrawBlock {
+    DrawData draws[];
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+void main()
+{
+    DrawData draw = draws[gl_BaseInstanceARB]; // the draw index, IndirectBatch puts it in baseInstance
+    vec4 viewPos = view * draw.model * vec4(aPos, 1.0);
+    gl_Position = projection * viewPos;
+    FragPos = vec3(viewPos);
+    Normal = mat3(view) * draw.normalMatrix * aNormal; // view is rigid so its normal matrix is itself
+    TexCoords = aTexCoords;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in mat3 aNormalMatrix;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+void main()
+{
+    vec4 viewPos = view * aModel * vec4(aPos, 1.0);
+    gl_Position = projection * viewPos;
+    FragPos = vec3(viewPos);
+    Normal = mat3(view) * aNormalMatrix * aNormal; // view is rigid so its normal matrix is itself
+    TexCoords = aTexCoords;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#version 330 core
+// same as fullVtx.glsl for meshes from uploadQuantizedMesh, attributes arrive normalized to [0, 1] / [-1, 1]
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+uniform mat4 modelView;
+uniform mat3 normalMatrix;
+uniform mat4 projection;
+
+// mesh AABB and uv bounds, the identity decode also draws the float layouts
+uniform vec3 posOffset;
+uniform vec3 posScale;
+uniform vec2 uvOffset;
+uniform vec2 uvScale;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+void main()
+{
+    vec4 viewPos = modelView * vec4(posOffset + posScale * aPos, 1.0);
+    gl_Position = projection * viewPos;
+    FragPos = vec3(viewPos);
+    Normal = normalMatrix * aNormal;
+    TexCoords = uvOffset + uvScale * aTexCoords;
+}
\ No newline at end of file
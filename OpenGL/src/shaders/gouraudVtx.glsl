@@ -2,7 +2,8 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 
-uniform mat4 model;
+uniform mat4 modelView;
+uniform mat3 normalMatrix;
 uniform mat4 view;
 uniform mat4 projection;
 uniform vec3 lightColor;
@@ -15,11 +16,11 @@ out vec3 PhongLight;
 
 void main()
 {
-    vec3 vtxPos = vec3(view * model * vec4(aPos, 1.0));
+    vec3 vtxPos = vec3(modelView * vec4(aPos, 1.0));
     gl_Position = projection * vec4(vtxPos, 1.0);
     vec3 ambient = ambientStr * lightColor;
 
-    vec3 norm = normalize(mat3(transpose(inverse(view * model))) * aNormal);
+    vec3 norm = normalize(normalMatrix * aNormal);
     vec3 lightDir = normalize(vec3(view * vec4(lightPos, 1.0)) - vtxPos);
 
     float diff = max(dot(norm, lightDir), 0.0);
@@ -20,26 +20,23 @@ struct DirLight {
     vec3 specular;
 };
 
+// scalars fill the padding after each vec3 so the std140 layout matches LightBlock in lightBlock.hpp
 struct PointLight {
     vec3 position;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-
     float constant;
+    vec3 ambient;
     float linear;
+    vec3 diffuse;
     float quadratic;
+    vec3 specular;
 };
 
 struct FlashLight {
-    float innerCone;
-    float outerCone;
-
     vec3 ambient;
+    float innerCone;
     vec3 diffuse;
+    float outerCone;
     vec3 specular;
-
     float constant;
     float linear;
     float quadratic;
@@ -47,10 +44,12 @@ struct FlashLight {
   
 uniform mat4 view;
 uniform Material material;
-uniform DirLight dirLight;
 #define NR_POINT_LIGHTS 4  
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform FlashLight flashLight;
+layout (std140) uniform LightBlock {
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+    FlashLight flashLight;
+};
 
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
@@ -0,0 +1,27 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// which vector paths the kernels in culling, mipmap and bcn can be built with. SSE is part of x86-64 so it is
+// always there, AVX2 is compiled per function with a target attribute and only taken when simdHasAVX2 says so
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_SSE 1
+#if defined(__GNUC__)
+#define SIMD_AVX2 1
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SIMD_NEON 1
+#endif
+
+// asked once, the CPU does not change under a running process
+bool simdHasAVX2() {
+#ifdef SIMD_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+#endif
\ No newline at end of file
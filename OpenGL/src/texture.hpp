@@ -1,33 +1,215 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "ddsFile.hpp"
+#include "glResource.hpp"
+#include "mipmap.hpp"
+#include "sampler.hpp"
 #include "shader.hpp"
 #include "stb_image.hpp"
 
-unsigned int loadTexture(char const * path)
+// level 0 plus a full mip chain
+size_t textureBytes(int width, int height, int components) { return (size_t)width * height * components * 4 / 3; }
+
+// an RGBA8 image and its mip chain block compressed level by level, what textureCooker writes to disk
+BcnImage cookTexture(JobSystem& jobs, BcnFormat format, bool srgb, const unsigned char* rgba, int width, int height,
+                     const MipOptions& mips = MipOptions()) {
+    BcnImage image;
+    image.format = format;
+    image.srgb = srgb;
+    std::vector<unsigned char> chain(mipChainBytes(width, height, 4));
+    generateMipChain(&jobs, rgba, width, height, 4, chain.data(), mips);
+    const unsigned char* level = rgba;
+    for (int i = 0, count = mipLevelCount(width, height); i < count; i++) {
+        size_t bytes = bcnLevelBytes(format, width, height);
+        image.levels.push_back({ image.blocks.size(), bytes, width, height });
+        image.blocks.resize(image.blocks.size() + bytes);
+        bcnEncodeLevel(jobs, format, level, width, height, &image.blocks[image.levels.back().offset]);
+        level = i == 0 ? chain.data() : level + (size_t)width * height * 4;
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return image;
+}
+
+// how a file becomes a texture, everything here is part of a TextureCache key. How it is sampled is not, that is
+// a SamplerDesc bound next to it so the one image serves every wrap and filter.
+struct TextureOptions {
+    bool srgb = false; // colour stored as sRGB, sampling returns it linear
+    MipFilter mipFilter = MipFilter::Box;
+    bool normalMap = false;
+
+    bool operator==(const TextureOptions& o) const {
+        return srgb == o.srgb && mipFilter == o.mipFilter && normalMap == o.normalMap;
+    }
+
+    MipOptions mips() const {
+        MipOptions mips;
+        mips.filter = mipFilter;
+        mips.srgb = srgb && !normalMap;
+        mips.normalMap = normalMap;
+        return mips;
+    }
+};
+
+GLenum texturePixelFormat(int components) { return components == 1 ? GL_RED : components == 3 ? GL_RGB : GL_RGBA; }
+
+GLenum textureInternalFormat(int components, bool srgb) {
+    if (components == 1) return GL_R8;
+    if (components == 3) return srgb ? GL_SRGB8 : GL_RGB8;
+    return srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+}
+
+// immutable storage is checked for completeness once when it is made rather than at draws, core since 4.2
+bool textureStorageSupported() {
+    static bool supported = glVersionAtLeast(4, 2) || hasGLExtension("GL_ARB_texture_storage");
+    return supported;
+}
+
+// every level of the texture bound to GL_TEXTURE_2D, contents undefined until glTexSubImage2D or
+// glCompressedTexSubImage2D fills them. blockBytes is 8 or 16 for a block compressed internalFormat, 0 otherwise.
+// Without glTexStorage2D the levels are specified one at a time and MAX_LEVEL marks where the chain ends.
+void allocateTextureStorage(GLenum internalFormat, int levels, int width, int height, size_t blockBytes = 0) {
+    if (textureStorageSupported()) {
+        glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+        return;
+    }
+    GLenum format = internalFormat == GL_R8 ? GL_RED : internalFormat == GL_RGB8 || internalFormat == GL_SRGB8 ? GL_RGB : GL_RGBA;
+    for (int i = 0; i < levels; i++) {
+        if (blockBytes)
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, internalFormat, width, height, 0, (GLsizei)(((width + 3) / 4) * ((height + 3) / 4) * blockBytes), nullptr);
+        else glTexImage2D(GL_TEXTURE_2D, i, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+}
+
+// block compressed formats the context samples natively, RGTC is core since 3.0 and BPTC since 4.2
+struct BcnSupport {
+    bool s3tc = false, s3tcSrgb = false, rgtc = true, bptc = false;
+};
+
+// cooked textures are decoded on the CPU as if the context had none of the formats, set by --decompress-textures
+bool forceTextureDecompression = false;
+
+// queried on the GL thread the first time, safe to read from the loader's threads after that
+const BcnSupport& bcnSupport() {
+    static BcnSupport support = []() {
+        BcnSupport s;
+        s.s3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+        s.s3tcSrgb = s.s3tc && (hasGLExtension("GL_EXT_texture_sRGB") || hasGLExtension("GL_EXT_texture_compression_s3tc_srgb"));
+        s.bptc = glVersionAtLeast(4, 2) || hasGLExtension("GL_ARB_texture_compression_bptc");
+        return s;
+    }();
+    return support;
+}
+
+bool bcnSupported(BcnFormat format, bool srgb) {
+    if (forceTextureDecompression) return false;
+    const BcnSupport& support = bcnSupport();
+    switch (format) {
+    case BcnFormat::BC1:
+    case BcnFormat::BC3: return srgb ? support.s3tcSrgb : support.s3tc;
+    case BcnFormat::BC4:
+    case BcnFormat::BC5: return support.rgtc;
+    default: return support.bptc;
+    }
+}
+
+bool isCookedTexture(const char* path) {
+    size_t length = strlen(path);
+    return length > 4 && !strcmp(path + length - 4, ".dds");
+}
+
+// what textureCooker writes for path when it has been cooked, path itself otherwise
+std::string cookedTexturePath(const char* path) {
+    std::string cooked = path;
+    cooked = cooked.substr(0, cooked.find_last_of('.')) + ".dds";
+    struct stat st;
+    return stat(cooked.c_str(), &st) == 0 ? cooked : path;
+}
+
+// a textureCooker file. The levels go to glCompressedTexSubImage2D straight out of the mapping when the context has the
+// format, otherwise each is decoded to RGBA8 first, which costs the VRAM savings but keeps the sample running.
+Texture loadCompressedTexture(const char* path, const TextureOptions& options = TextureOptions())
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+    PROFILE_SCOPE("loadTexture");
+    Texture texture;
+    texture.generate();
+    MappedFile file(path);
+    BcnImage image;
+    if (!file.valid() || !readDdsFile(file, path, image)) return texture;
+    file.adviseSequential();
+
+    bool srgb = image.srgb || options.srgb;
+    const BcnLevel& base = image.levels[0];
+    GLsizei levels = (GLsizei)image.levels.size();
+    texture.bind();
+    size_t bytes = 0;
+    if (bcnSupported(image.format, srgb)) {
+        GLenum format = bcnGLFormat(image.format, srgb);
+        allocateTextureStorage(format, levels, base.width, base.height, bcnBlockBytes(image.format));
+        for (GLsizei i = 0; i < levels; i++) {
+            const BcnLevel& level = image.levels[i];
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, format, (GLsizei)level.bytes, file.data() + level.offset);
+            bytes += level.bytes;
+        }
+    } else {
+        allocateTextureStorage(textureInternalFormat(4, srgb), levels, base.width, base.height);
+        std::vector<uint8_t> rgba;
+        bool decoded = true;
+        for (GLsizei i = 0; i < levels; i++) {
+            const BcnLevel& level = image.levels[i];
+            rgba.resize((size_t)level.width * level.height * 4);
+            decoded &= bcnDecodeLevel(image.format, (const uint8_t*)file.data() + level.offset, level.width, level.height, rgba.data());
+            glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+            bytes += rgba.size();
+        }
+        checkBcnDecode(decoded, path);
+    }
+    texture.track(bytes);
+    return texture;
+}
+
+Texture loadTexture(char const * path, const TextureOptions& options = TextureOptions())
+{
+    if (isCookedTexture(path)) return loadCompressedTexture(path, options);
+    PROFILE_SCOPE("loadTexture");
+    Texture texture;
+    texture.generate();
 
     int width, height, nrComponents;
     unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
     if (data)
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        GLenum format = texturePixelFormat(nrComponents), internalFormat = textureInternalFormat(nrComponents, options.srgb);
+        // the chain is filtered on the CPU rather than by glGenerateMipmap, see mipmap.hpp
+        std::vector<unsigned char> chain(mipChainBytes(width, height, nrComponents));
+        generateMipChain(nullptr, data, width, height, nrComponents, chain.data(), options.mips());
+
+        texture.bind();
+        int count = mipLevelCount(width, height);
+        allocateTextureStorage(internalFormat, count, width, height);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // RGB rows of odd widths are not 4 byte aligned
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+        const unsigned char* level = chain.data();
+        for (int i = 1, w = width, h = height; i < count; i++) {
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+            glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, w, h, format, GL_UNSIGNED_BYTE, level);
+            level += (size_t)w * h * nrComponents;
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        texture.track(textureBytes(width, height, nrComponents));
 
         stbi_image_free(data);
     }
@@ -37,34 +219,43 @@ unsigned int loadTexture(char const * path)
         stbi_image_free(data);
     }
 
-    return textureID;
+    return texture;
 }
 
 void tutTexture(Shader &shader) {
+    PROFILE_SCOPE("loadTexture");
     int height, width, nrChannels;
     stbi_set_flip_vertically_on_load(true);
     unsigned char *data = stbi_load("../public/container.jpg", &width, &height, &nrChannels, 0);
-    unsigned int textures[2];
-    glGenTextures(2, textures);
-    glBindTexture(GL_TEXTURE_2D, textures[0]);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+    // kept alive between calls, calling again replaces them
+    static Texture textures[2];
+    textures[0].generate();
+    textures[0].bind();
+    allocateTextureStorage(GL_RGB8, mipLevelCount(width, height), width, height);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, data);
     glGenerateMipmap(GL_TEXTURE_2D);
+    textures[0].track(textureBytes(width, height, 3));
+    stbi_image_free(data);
 
     data = stbi_load("../public/awesomeface.png", &width, &height, &nrChannels, 0);
-    glBindTexture(GL_TEXTURE_2D, textures[1]);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    textures[1].generate();
+    textures[1].bind();
+    allocateTextureStorage(GL_RGB8, mipLevelCount(width, height), width, height);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
     glGenerateMipmap(GL_TEXTURE_2D);
+    textures[1].track(textureBytes(width, height, 3));
+    stbi_image_free(data);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textures[0]);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, textures[1]);
+    // the container keeps GL's default minification, the face mirrors across and clamps down
+    SamplerDesc container(GL_REPEAT, GL_NEAREST_MIPMAP_LINEAR, GL_NEAREST), face(GL_MIRRORED_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_NEAREST);
+    face.wrapT = GL_CLAMP_TO_EDGE;
+    textures[0].bind(0, GL_TEXTURE_2D);
+    textures[1].bind(1, GL_TEXTURE_2D);
+    samplerCache().get(container).bind(0);
+    samplerCache().get(face).bind(1);
     shader.use();
     shader.setInt("texture1", 0);
     shader.setInt("texture2", 1);
-}
\ No newline at end of file
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,169 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "glResource.hpp"
+#include "texture.hpp"
+#include "textureLoader.hpp"
+
+struct TextureCacheEntry {
+    std::string key;
+    Texture texture;
+    GLuint placeholder = 0; // id while a TextureLoader still owes the real texture
+    uint32_t refs = 0;
+    bool failed = false; // the loader gave up on the file, the placeholder stays
+
+    bool resident() const { return texture.id() != placeholder; }
+    // the loader is done with the texture one way or the other, so it may be evicted
+    bool settled() const { return resident() || failed; }
+};
+
+// shared reference to a cached texture, kept from eviction while any handle to it is alive. GL thread only like the cache.
+class TextureHandle {
+private:
+    TextureCacheEntry* entry = nullptr;
+
+    explicit TextureHandle(TextureCacheEntry* entry) : entry(entry) {
+        if (entry) entry->refs++;
+    }
+    friend class TextureCache;
+public:
+    TextureHandle() = default;
+    TextureHandle(const TextureHandle& other) : TextureHandle(other.entry) {}
+    TextureHandle(TextureHandle&& other) noexcept : entry(other.entry) { other.entry = nullptr; }
+    TextureHandle& operator=(TextureHandle other) noexcept {
+        std::swap(entry, other.entry);
+        return *this;
+    }
+    ~TextureHandle() {
+        if (entry) entry->refs--;
+    }
+
+    // stays valid for the handle's lifetime, a streamed texture is swapped in behind the same pointer
+    const Texture* get() const { return entry ? &entry->texture : nullptr; }
+    const Texture& operator*() const { return entry->texture; }
+    const Texture* operator->() const { return &entry->texture; }
+    explicit operator bool() const { return entry != nullptr; }
+
+    void bind(GLuint unit, GLenum target) const {
+        if (entry) entry->texture.bind(unit, target);
+    }
+};
+
+struct TextureCacheStats {
+    size_t hits = 0, misses = 0, evictions = 0, failures = 0;
+};
+
+// one texture per canonical path and TextureOptions, shared through TextureHandles. A repeated request is a hit even
+// while the first one is still streaming, so a file is only decoded and uploaded once. Textures nothing holds any more
+// stay cached and are evicted least recently used first once the cache is over budget.
+class TextureCache {
+private:
+    std::list<TextureCacheEntry> entries; // most recently used first, nodes never move so handles can point into them
+    std::unordered_map<std::string, std::list<TextureCacheEntry>::iterator> index;
+    TextureCacheStats counts;
+
+    static std::string makeKey(const char* path, const TextureOptions& options) {
+        char resolved[PATH_MAX];
+        std::string key = realpath(path, resolved) ? resolved : path;
+        return key + (options.srgb ? "|srgb" : "|linear") + (options.mipFilter == MipFilter::Kaiser ? "|kaiser" : "|box")
+               + (options.normalMap ? "|normal" : "");
+    }
+
+    static size_t entryBytes(const TextureCacheEntry& entry) { return glResources().bytes(GLResourceType::Texture, entry.texture.id()); }
+public:
+    // GPU bytes the cache may keep, only textures without handles are ever evicted to meet it
+    size_t budget = 256 << 20;
+    // streams misses in behind a placeholder when set, loadTexture otherwise. Must outlive every pending request.
+    TextureLoader* loader = nullptr;
+
+    // placeholder is the colour shown until a streamed texture is resident
+    TextureHandle acquire(const char* path, const TextureOptions& options = TextureOptions(), const glm::vec4& placeholder = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f)) {
+        std::string key = makeKey(path, options);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            counts.hits++;
+            entries.splice(entries.begin(), entries, it->second);
+            return TextureHandle(&entries.front());
+        }
+        counts.misses++;
+        entries.emplace_front();
+        TextureCacheEntry& entry = entries.front();
+        entry.key = key;
+        if (loader) {
+            // a failed file leaves the index so the next acquire tries it again, handles keep the placeholder
+            TextureCacheEntry* failing = &entry;
+            loader->request(path, entry.texture, options, placeholder, [this, failing]() {
+                failing->failed = true;
+                counts.failures++;
+                auto found = index.find(failing->key);
+                if (found != index.end() && &*found->second == failing) index.erase(found);
+            });
+            entry.placeholder = entry.texture.id();
+        } else {
+            entry.texture = loadTexture(path, options);
+        }
+        index[key] = entries.begin();
+        TextureHandle handle(&entry);
+        trim();
+        return handle;
+    }
+
+    // evicts the least recently used textures without handles until the cache fits its budget,
+    // textures still streaming are skipped since the loader writes into them
+    void trim() {
+        size_t total = bytes();
+        for (auto it = entries.end(); it != entries.begin() && total > budget;) {
+            --it;
+            if (it->refs > 0 || !it->settled()) continue;
+            total -= entryBytes(*it);
+            auto found = index.find(it->key); // a failed entry's key may already belong to a retry
+            if (found != index.end() && found->second == it) index.erase(found);
+            it = entries.erase(it);
+            counts.evictions++;
+        }
+    }
+
+    // drops every texture without handles, e.g. between samples
+    void clear() {
+        size_t saved = budget;
+        budget = 0;
+        trim();
+        budget = saved;
+    }
+
+    size_t bytes() const {
+        size_t total = 0;
+        for (const TextureCacheEntry& entry : entries) total += entryBytes(entry);
+        return total;
+    }
+
+    size_t size() const { return entries.size(); }
+    const TextureCacheStats& stats() const { return counts; }
+
+    void print() const {
+        size_t held = 0;
+        for (const TextureCacheEntry& entry : entries) held += entry.refs > 0;
+        std::cout << "texture cache: " << entries.size() << " textures (" << held << " held), " << std::fixed << std::setprecision(1)
+                  << bytes() / (1024.0 * 1024.0) << " of " << budget / (1024.0 * 1024.0) << " MB, " << counts.hits << " hits, "
+                  << counts.misses << " misses, " << counts.evictions << " evictions, " << counts.failures << " failed" << std::endl;
+    }
+};
+
+// never destroyed, like glResources, so handles in globals can still let go after main returns
+TextureCache& textureCache() {
+    static TextureCache* cache = new TextureCache();
+    return *cache;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+// offline tool, built on its own next to glad.c rather than with main.cpp:
+//   textureCooker <input image> [<output.dds>] [--format bc1 | bc3 | bc4 | bc5 | bc7] [--srgb] [--normal] [--mip box | kaiser] [--threads N]
+// the output defaults to the input with a .dds extension, e.g. for f in ../public/*.png ../public/*.jpg; do textureCooker $f; done
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ddsFile.hpp"
+#include "jobs.hpp"
+#include "texture.hpp"
+
+bool parseFormat(const char* name, BcnFormat& format) {
+    static const char* names[] = { "bc1", "bc3", "bc4", "bc5", "bc7" };
+    for (int i = 0; i < 5; i++)
+        if (!strcmp(name, names[i])) {
+            format = (BcnFormat)i;
+            return true;
+        }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <input image> [<output.dds>] [--format bc1 | bc3 | bc4 | bc5 | bc7] [--srgb] [--normal] [--mip box | kaiser] [--threads N]" << std::endl;
+        return 1;
+    }
+    const char* input = argv[1];
+    std::string output = input;
+    output = output.substr(0, output.find_last_of('.')) + ".dds";
+    bool formatGiven = false, srgb = false;
+    BcnFormat format = BcnFormat::BC1;
+    unsigned threads = 0;
+    MipOptions mips;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--format") && i + 1 < argc) {
+            if (!parseFormat(argv[++i], format)) {
+                std::cerr << "ERROR::TEXTURE_COOKER::UNKNOWN_FORMAT " << argv[i] << std::endl;
+                return 1;
+            }
+            formatGiven = true;
+        } else if (!strcmp(argv[i], "--srgb")) srgb = true;
+        else if (!strcmp(argv[i], "--normal")) mips.normalMap = true;
+        else if (!strcmp(argv[i], "--mip") && i + 1 < argc) mips.filter = strcmp(argv[++i], "kaiser") ? MipFilter::Box : MipFilter::Kaiser;
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = (unsigned)atoi(argv[++i]);
+        else if (argv[i][0] != '-') output = argv[i];
+    }
+
+    int width, height, components;
+    unsigned char* data = stbi_load(input, &width, &height, &components, 4);
+    if (!data) {
+        std::cerr << "ERROR::TEXTURE_COOKER::LOAD_FAILED " << input << std::endl;
+        return 1;
+    }
+    // opaque colour fits BC1, anything with alpha goes to BC7 and normal maps keep x and y in BC5
+    if (!formatGiven) format = mips.normalMap ? BcnFormat::BC5 : components == 2 || components == 4 ? BcnFormat::BC7 : BcnFormat::BC1;
+    mips.srgb = srgb && !mips.normalMap;
+
+    JobSystem jobs(threads);
+    auto start = std::chrono::steady_clock::now();
+    BcnImage image = cookTexture(jobs, format, srgb, data, width, height, mips);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    size_t texels = 0;
+    for (const BcnLevel& level : image.levels) texels += (size_t)level.width * level.height;
+    if (!writeDdsFile(output.c_str(), image)) {
+        stbi_image_free(data);
+        return 1;
+    }
+
+    std::vector<uint8_t> decoded((size_t)width * height * 4);
+    bcnDecodeLevel(format, image.blocks.data(), width, height, decoded.data());
+    double psnr = bcnPsnr(format, data, decoded.data(), (size_t)width * height);
+    stbi_image_free(data);
+    std::cout << "wrote " << output << ": " << width << "x" << height << " " << bcnFormatName(format) << (srgb ? " sRGB" : "") << ", "
+              << image.levels.size() << " levels, " << image.blocks.size() / 1024 << " KB (RGBA8 " << texels * 4 / 1024 << " KB), "
+              << ms << " ms on " << jobs.threadCount() << " threads (" << texels / ms / 1000.0 << " MPix/s), PSNR "
+              << psnr << " dB" << std::endl;
+    return 0;
+}
\ No newline at end of file
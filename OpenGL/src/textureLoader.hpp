@@ -0,0 +1,319 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "glResource.hpp"
+#include "glState.hpp"
+#include "profiler.hpp"
+#include "texture.hpp"
+#include "trace.hpp"
+
+struct TextureLoaderStats {
+    size_t requested = 0, decoded = 0, resident = 0, failed = 0;
+    size_t bytesUploaded = 0;
+};
+
+// loadTexture without stalling the frame: files are decoded and filtered down to 1x1 on a small thread pool, then
+// every level goes up through a ring of pixel unpack buffers a few rows at a time under a per frame byte budget.
+// glGenerateMipmap is left out on purpose, on a big texture it is a hitch of its own. Cooked .dds files bring their
+// own chain and go up as blocks. Until the last row is in every target holds a 1x1 placeholder.
+// Only update() and request() touch GL, both on the context thread.
+class TextureLoader {
+private:
+    // texture uploads bind here so the units samples rely on keep their textures
+    static const GLuint UPLOAD_UNIT = GLStateCache::MAX_TEXTURE_UNITS - 1;
+
+    struct Request {
+        std::string path;
+        Texture* target;
+        TextureOptions options;
+        std::function<void()> failed; // optional, called from update() when the file could not be decoded
+    };
+    // uploaded a row at a time, a row being 4 texels high for block compressed levels
+    struct Level {
+        size_t offset;
+        int width, height;
+        size_t rowBytes;
+        int rows, rowHeight;
+    };
+    struct Image {
+        Request request;
+        std::vector<unsigned char> pixels; // every level back to back, empty when decoding failed
+        std::vector<Level> levels;
+        int components = 0;
+        GLenum compressedFormat = 0; // blocks for glCompressedTexSubImage2D instead of pixels when set
+    };
+    struct Upload {
+        Image image;
+        Texture texture;
+        size_t level = 0;
+        int nextRow = 0;
+    };
+    struct StagingSlot {
+        Buffer pbo;
+        size_t bytes = 0;
+        GLsync fence = nullptr; // signalled once the GPU has read the last upload out of pbo
+    };
+
+    std::vector<std::thread> decoders;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Request> requests;
+    std::deque<Image> decoded;
+    bool stopping = false;
+
+    std::deque<Upload> uploads; // GL thread only from here on
+    std::vector<StagingSlot> slots;
+    size_t nextSlot = 0;
+    TextureLoaderStats counts;
+
+    void decodeLoop() {
+        for (;;) {
+            Image image;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stopping || !requests.empty(); });
+                if (stopping) return;
+                image.request = std::move(requests.front());
+                requests.pop_front();
+            }
+            decode(image);
+            std::lock_guard<std::mutex> lock(mutex);
+            counts.decoded += !image.pixels.empty();
+            decoded.push_back(std::move(image));
+        }
+    }
+
+    static void decode(Image& image) {
+        TraceScope trace("decodeTexture", "texture");
+        if (isCookedTexture(image.request.path.c_str())) {
+            decodeCooked(image);
+            return;
+        }
+        int width, height;
+        unsigned char* data = stbi_load(image.request.path.c_str(), &width, &height, &image.components, 0);
+        if (!data) return;
+        size_t bytes = 0;
+        for (int level = 0, count = mipLevelCount(width, height); level < count; level++) {
+            size_t rowBytes = (size_t)width * image.components;
+            image.levels.push_back({ bytes, width, height, rowBytes, height, 1 });
+            bytes += rowBytes * height;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        image.pixels.resize(bytes);
+        const Level& base = image.levels[0];
+        memcpy(image.pixels.data(), data, (size_t)base.width * base.height * image.components);
+        stbi_image_free(data);
+        if (image.levels.size() > 1) {
+            // these threads already work on a file each, so the chain is not split any further
+            generateMipChain(nullptr, image.pixels.data(), base.width, base.height, image.components, &image.pixels[image.levels[1].offset],
+                             image.request.options.mips());
+        }
+    }
+
+    // cooked chains are copied out as blocks, or decoded to RGBA8 when the context lacks the format
+    static void decodeCooked(Image& image) {
+        const char* path = image.request.path.c_str();
+        MappedFile file(path);
+        BcnImage cooked;
+        if (!file.valid() || !readDdsFile(file, path, cooked)) return;
+        bool srgb = cooked.srgb || image.request.options.srgb;
+        bool native = bcnSupported(cooked.format, srgb);
+        size_t bytes = 0;
+        for (const BcnLevel& level : cooked.levels) {
+            if (native) {
+                int rows = (level.height + 3) / 4;
+                image.levels.push_back({ bytes, level.width, level.height, level.bytes / rows, rows, 4 });
+                bytes += level.bytes;
+            } else {
+                image.levels.push_back({ bytes, level.width, level.height, (size_t)level.width * 4, level.height, 1 });
+                bytes += (size_t)level.width * level.height * 4;
+            }
+        }
+        image.pixels.resize(bytes);
+        bool decoded = true;
+        for (size_t i = 0; i < cooked.levels.size(); i++) {
+            const uint8_t* blocks = (const uint8_t*)file.data() + cooked.levels[i].offset;
+            if (native) memcpy(&image.pixels[image.levels[i].offset], blocks, cooked.levels[i].bytes);
+            else decoded &= bcnDecodeLevel(cooked.format, blocks, cooked.levels[i].width, cooked.levels[i].height, &image.pixels[image.levels[i].offset]);
+        }
+        checkBcnDecode(decoded, path);
+        image.components = 4;
+        if (native) image.compressedFormat = bcnGLFormat(cooked.format, srgb);
+    }
+
+    // storage for the whole chain, filled in by uploadRows
+    void begin(Upload& upload) {
+        const Image& image = upload.image;
+        glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); // a null pointer would be an offset into the staging buffer
+        upload.texture.generate();
+        upload.texture.bind(UPLOAD_UNIT, GL_TEXTURE_2D);
+        const Level& base = image.levels[0];
+        if (image.compressedFormat)
+            allocateTextureStorage(image.compressedFormat, (int)image.levels.size(), base.width, base.height, base.rowBytes / ((base.width + 3) / 4));
+        else allocateTextureStorage(textureInternalFormat(image.components, image.request.options.srgb), (int)image.levels.size(), base.width, base.height);
+        upload.texture.track(image.pixels.size());
+    }
+
+    // the placeholder's units get the real texture before the placeholder is deleted
+    void finish(Upload& upload) {
+        Texture& target = *upload.image.request.target;
+        glState().rebindTexture(GL_TEXTURE_2D, target.id(), upload.texture.id());
+        target = std::move(upload.texture);
+        counts.resident++;
+    }
+
+    // copies up to budget bytes of whole rows of the current level into the next staging buffer and starts the transfer
+    // from there, 0 when that buffer is still being read by the GPU
+    size_t uploadRows(Upload& upload, size_t budget) {
+        const Image& image = upload.image;
+        const Level& level = image.levels[upload.level];
+        StagingSlot& slot = slots[nextSlot];
+        if (slot.fence) {
+            if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED) return 0;
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+        size_t rowBytes = level.rowBytes;
+        int rows = (int)std::min<size_t>(level.rows - upload.nextRow, std::max<size_t>(1, std::min(budget, slot.bytes) / rowBytes));
+        size_t bytes = rows * rowBytes;
+        TraceScope trace("textureRows", "upload", (int64_t)bytes);
+        if (bytes > slot.bytes) {
+            slot.pbo.data(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+            slot.bytes = bytes;
+        }
+        slot.pbo.bind(GL_PIXEL_UNPACK_BUFFER);
+        // the fence says the GPU is done with the old contents, no need for the driver to check again
+        void* staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!staging) return 0;
+        memcpy(staging, &image.pixels[level.offset + upload.nextRow * rowBytes], bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        upload.texture.bind(UPLOAD_UNIT, GL_TEXTURE_2D);
+        int y = upload.nextRow * level.rowHeight, height = std::min(rows * level.rowHeight, level.height - y);
+        if (image.compressedFormat)
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)upload.level, 0, y, level.width, height, image.compressedFormat, (GLsizei)bytes, nullptr);
+        else glTexSubImage2D(GL_TEXTURE_2D, (GLint)upload.level, 0, y, level.width, height, texturePixelFormat(image.components), GL_UNSIGNED_BYTE, nullptr);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        nextSlot = (nextSlot + 1) % slots.size();
+        upload.nextRow += rows;
+        if (upload.nextRow == level.rows) {
+            upload.level++;
+            upload.nextRow = 0;
+        }
+        counts.bytesUploaded += bytes;
+        return bytes;
+    }
+public:
+    // bytes of level 0 that may go up per update(), one row always does
+    size_t frameBudget;
+
+    // threads 0 is one per core but the render thread's
+    TextureLoader(unsigned int threads = 0, size_t frameBudget = 4 << 20, int stagingBuffers = 3, size_t stagingBytes = 4 << 20)
+        : slots(std::max(stagingBuffers, 1)), frameBudget(frameBudget) {
+        if (threads == 0) threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        bcnSupport(); // queried here on the GL thread, the decoders only read it
+        for (StagingSlot& slot : slots) {
+            slot.pbo.data(GL_PIXEL_UNPACK_BUFFER, stagingBytes, nullptr, GL_STREAM_DRAW);
+            slot.bytes = stagingBytes;
+        }
+        glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        for (unsigned int i = 0; i < threads; i++) decoders.emplace_back(&TextureLoader::decodeLoop, this);
+    }
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // requests not decoded yet are dropped, their targets keep the placeholder
+    ~TextureLoader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& decoder : decoders) decoder.join();
+        for (StagingSlot& slot : slots)
+            if (slot.fence && glResources().hasContext()) glDeleteSync(slot.fence);
+    }
+
+    // target gets a 1x1 placeholder of the given colour right away and the decoded file once it is resident,
+    // bound on the same units the placeholder was bound to through glState. target must stay put until then.
+    // A file that fails to decode leaves target on the placeholder for good and calls failed on the GL thread.
+    void request(const char* path, Texture& target, const TextureOptions& options = TextureOptions(),
+                 const glm::vec4& placeholder = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), std::function<void()> failed = nullptr) {
+        unsigned char texel[4];
+        for (int i = 0; i < 4; i++) texel[i] = (unsigned char)(glm::clamp(placeholder[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+        target.generate();
+        target.bind(UPLOAD_UNIT, GL_TEXTURE_2D);
+        allocateTextureStorage(GL_RGBA8, 1, 1, 1); // a single level is complete under any sampler
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+        target.track(4);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requests.push_back({ path, &target, options, std::move(failed) });
+            counts.requested++;
+        }
+        wake.notify_one();
+    }
+
+    // once per frame on the GL thread, picks up decoded files and uploads rows until the budget is spent
+    void update() {
+        PROFILE_SCOPE("textureStreaming");
+        std::vector<std::function<void()>> failures;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (Image& image : decoded) {
+                if (!image.pixels.empty()) {
+                    uploads.emplace_back();
+                    uploads.back().image = std::move(image);
+                    continue;
+                }
+                std::cerr << "ERROR::TEXTURE_LOADER::DECODE_FAILED " << image.request.path << std::endl;
+                counts.failed++;
+                if (image.request.failed) failures.push_back(std::move(image.request.failed));
+            }
+            decoded.clear();
+        }
+        for (auto& failed : failures) failed(); // outside the lock, they may request again
+        if (uploads.empty()) return;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows are tightly packed, RGB widths need not be a multiple of 4
+        size_t budget = frameBudget;
+        while (!uploads.empty() && budget > 0) {
+            Upload& upload = uploads.front();
+            if (!upload.texture) begin(upload);
+            size_t bytes = uploadRows(upload, budget);
+            if (bytes == 0) break;
+            budget -= std::min(budget, bytes);
+            if (upload.level == upload.image.levels.size()) {
+                finish(upload);
+                uploads.pop_front();
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    // nothing requested is left to decode or upload
+    bool idle() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return counts.resident + counts.failed == counts.requested;
+    }
+
+    TextureLoaderStats stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return counts;
+    }
+};
+
+#endif
\ No newline at end of file
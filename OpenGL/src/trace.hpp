@@ -0,0 +1,237 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// one Chrome trace event, names and categories must be string literals since only the pointer is kept
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    int64_t startNs, durNs; // steady_clock, or GPU time already moved onto it
+    int64_t arg;
+    uint32_t tid;
+    char phase; // 'X' complete, 'i' instant
+};
+
+// single producer ring owned by one thread at a time, the oldest events are overwritten once it is full.
+// A copy can run while the producer pushes: claimed moves before a slot is overwritten and written after, so a
+// reader that re-reads claimed once it is done knows which of the slots it copied may have changed under it.
+class TraceRing {
+private:
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> claimed{ 0 }, written{ 0 };
+public:
+    explicit TraceRing(size_t capacity) : events(capacity) {}
+
+    void push(const TraceEvent& event) {
+        uint64_t n = written.load(std::memory_order_relaxed);
+        claimed.store(n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        events[n % events.size()] = event;
+        written.store(n + 1, std::memory_order_release);
+    }
+
+    uint64_t count() const { return written.load(std::memory_order_acquire); }
+
+    // everything pushed since from that has not been overwritten yet, events the producer lapped while they
+    // were being copied are dropped rather than returned torn
+    void copySince(uint64_t from, std::vector<TraceEvent>& out) const {
+        uint64_t n = count();
+        from = std::max(from, n > events.size() ? n - events.size() : 0);
+        size_t first = out.size();
+        for (uint64_t i = from; i < n; i++) out.push_back(events[i % events.size()]);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t overwritten = claimed.load(std::memory_order_relaxed);
+        overwritten = overwritten > events.size() ? overwritten - events.size() : 0;
+        if (overwritten > from) out.erase(out.begin() + first, out.begin() + first + (std::min(overwritten, n) - from));
+    }
+};
+
+class Tracer;
+Tracer& tracer();
+
+// bounded capture of CPU scopes, GPU timer results and uploads, written as Chrome Trace Event JSON for
+// chrome://tracing or Perfetto. Recording is lock free, the mutex is only taken when a thread first records.
+class Tracer {
+private:
+    struct RingEntry {
+        std::unique_ptr<TraceRing> ring;
+        uint64_t captureStart = 0; // ring->count() when the current capture began
+        bool inUse = false;
+    };
+    // hands the ring back once its thread exits, the next new thread picks it up and its events stay dumpable
+    struct ThreadRing {
+        TraceRing* ring = nullptr;
+        uint32_t tid = 0;
+        ~ThreadRing() {
+            if (ring) tracer().release(ring);
+        }
+    };
+
+    std::atomic<bool> capturing{ false };
+    std::mutex ringsMutex;
+    std::vector<RingEntry> rings;
+    std::atomic<uint32_t> nextTid{ 1 }; // 0 is the GPU timeline
+    uint32_t mainTid = 0;
+    int64_t captureStartNs = 0, gpuOffsetNs = 0;
+    bool gpuCalibrated = false;
+    int framesLeft = 0;
+    std::string path;
+
+    ThreadRing& threadRing() {
+        thread_local ThreadRing local;
+        if (!local.ring) {
+            local.tid = nextTid++;
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            for (RingEntry& entry : rings) {
+                if (entry.inUse) continue;
+                entry.inUse = true;
+                local.ring = entry.ring.get();
+                break;
+            }
+            if (!local.ring) {
+                rings.push_back({ std::unique_ptr<TraceRing>(new TraceRing(ringCapacity)), 0, true });
+                rings.back().captureStart = capturing ? rings.back().ring->count() : 0;
+                local.ring = rings.back().ring.get();
+            }
+        }
+        return local;
+    }
+
+    void release(TraceRing* ring) {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (RingEntry& entry : rings)
+            if (entry.ring.get() == ring) entry.inUse = false;
+    }
+public:
+    size_t ringCapacity = 1 << 16; // events per thread, set before the first capture
+
+    static int64_t now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+    bool active() const { return capturing.load(std::memory_order_relaxed); }
+
+    // call on the GL thread, GPU timestamps are lined up with the CPU clock here.
+    // frames > 0 stops and writes outputPath by itself after that many frames.
+    void start(const char* outputPath, int frames = 0) {
+        if (active()) return;
+        path = outputPath;
+        framesLeft = frames;
+        mainTid = threadRing().tid;
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            for (RingEntry& entry : rings) entry.captureStart = entry.ring->count();
+        }
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        captureStartNs = now();
+        gpuOffsetNs = gpuNow - captureStartNs;
+        gpuCalibrated = gpuNow != 0;
+        capturing = true;
+        std::cout << "trace capture started" << (frames > 0 ? ", " + std::to_string(frames) + " frames" : "") << std::endl;
+    }
+
+    // stops recording and writes the capture. Scopes that saw the capture running may still push while the rings
+    // are copied, TraceRing::copySince drops whatever they overwrite.
+    bool stop() {
+        if (!active()) return true;
+        capturing = false;
+        return write(path.c_str());
+    }
+
+    void toggle(const char* outputPath) {
+        if (active()) stop();
+        else start(outputPath);
+    }
+
+    // counts down a bounded capture, called once per frame
+    void frame() {
+        if (active() && framesLeft > 0 && --framesLeft == 0) stop();
+    }
+
+    void complete(const char* name, const char* category, int64_t startNs, int64_t durNs, int64_t arg = 0) {
+        ThreadRing& local = threadRing();
+        local.ring->push({ name, category, startNs, durNs, arg, local.tid, 'X' });
+    }
+
+    void instant(const char* name, const char* category, int64_t arg = 0) {
+        ThreadRing& local = threadRing();
+        local.ring->push({ name, category, now(), 0, arg, local.tid, 'i' });
+    }
+
+    // GL_TIMESTAMP values, recorded from the GL thread but shown on their own GPU row
+    void gpu(const char* name, uint64_t beginNs, uint64_t endNs) {
+        if (!gpuCalibrated) return;
+        int64_t start = (int64_t)beginNs - gpuOffsetNs;
+        if (start < captureStartNs) return; // issued before the capture
+        threadRing().ring->push({ name, "gpu", start, (int64_t)(endNs - beginNs), 0, 0, 'X' });
+    }
+
+    bool write(const char* outputPath) {
+        std::vector<TraceEvent> events;
+        uint32_t threads = 0;
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            for (const RingEntry& entry : rings) entry.ring->copySince(entry.captureStart, events);
+            threads = nextTid;
+        }
+        std::sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) { return a.startNs < b.startNs; });
+        FILE* file = fopen(outputPath, "w");
+        if (!file) {
+            std::cerr << "ERROR::TRACE::OPEN_FAILED " << outputPath << std::endl;
+            return false;
+        }
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}");
+        for (uint32_t tid = 1; tid < threads; tid++)
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}", tid,
+                    tid == mainTid ? "main" : "worker", tid);
+        for (const TraceEvent& e : events) {
+            if (e.startNs < captureStartNs) continue; // scopes still open when the capture began
+            double ts = (e.startNs - captureStartNs) / 1e3;
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u", e.name, e.category, e.phase, ts, e.tid);
+            if (e.phase == 'X') fprintf(file, ",\"dur\":%.3f", e.durNs / 1e3);
+            else fprintf(file, ",\"s\":\"t\"");
+            fprintf(file, ",\"args\":{\"value\":%lld}}", (long long)e.arg);
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+        std::cout << "wrote " << events.size() << " trace events to " << outputPath << std::endl;
+        return true;
+    }
+};
+
+// never destroyed, threads hand their rings back from thread_local destructors
+Tracer& tracer() {
+    static Tracer* instance = new Tracer();
+    return *instance;
+}
+
+// complete event around a block, one relaxed load while no capture is running
+class TraceScope {
+private:
+    const char* name;
+    const char* category;
+    int64_t arg;
+    int64_t start = 0;
+public:
+    TraceScope(const char* name, const char* category, int64_t arg = 0) : name(name), category(category), arg(arg) {
+        if (tracer().active()) start = Tracer::now();
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+    ~TraceScope() {
+        if (start && tracer().active()) tracer().complete(name, category, start, Tracer::now() - start, arg);
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <cmath>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include "shader.hpp"
+
+// inverse transpose of the upper 3x3, skipping the inverse when the columns are orthogonal with equal length,
+// i.e. any mix of rotations, translations and uniform scales, where it reduces to m / s^2
+glm::mat3 normalMatrix(const glm::mat3& m) {
+    float lx = glm::dot(m[0], m[0]), ly = glm::dot(m[1], m[1]), lz = glm::dot(m[2], m[2]);
+    float eps = 1e-4f * lx;
+    if (std::fabs(lx - ly) < eps && std::fabs(lx - lz) < eps
+        && std::fabs(glm::dot(m[0], m[1])) < eps && std::fabs(glm::dot(m[0], m[2])) < eps && std::fabs(glm::dot(m[1], m[2])) < eps)
+        return m * (1.0f / lx);
+    return glm::inverseTranspose(m);
+}
+
+glm::mat3 normalMatrix(const glm::mat4& m) { return normalMatrix(glm::mat3(m)); }
+
+// per-object uniforms of fullVtx.glsl and gouraudVtx.glsl, resolve once per frame then call set for every object
+struct ObjectTransform {
+    UniformHandle modelView, normal;
+
+    ObjectTransform(const Shader& shader) : modelView(shader.uniform("modelView")), normal(shader.uniform("normalMatrix")) {}
+
+    void set(const Shader& shader, const glm::mat4& view, const glm::mat4& model) const {
+        glm::mat4 mv = view * model;
+        shader.setMatrix(modelView, mv);
+        shader.setMat3(normal, normalMatrix(mv));
+    }
+
+    // matrices already computed off the GL thread, see buildPartyDraws
+    void setModelView(const Shader& shader, const glm::mat4& mv, const glm::mat3& normalMv) const {
+        shader.setMatrix(modelView, mv);
+        shader.setMat3(normal, normalMv);
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <glad/glad.h>
+#include <cstdint>
+
+// one glVertexAttribPointer call, fixed width fields so layouts can be written to disk as is
+struct VertexAttrib {
+    uint32_t location;
+    uint32_t components;
+    uint32_t type;
+    uint32_t normalized;
+    uint32_t offset;
+};
+
+struct VertexLayout {
+    static const int MAX_ATTRIBS = 4;
+    uint32_t stride = 0; // bytes
+    uint32_t count = 0;
+    VertexAttrib attribs[MAX_ATTRIBS] = {};
+
+    void add(uint32_t location, uint32_t components, GLenum type, bool normalized, uint32_t offset) {
+        attribs[count++] = { location, components, type, normalized ? 1u : 0u, offset };
+    }
+
+    // attribute pointers for the bound VAO and GL_ARRAY_BUFFER
+    void apply() const {
+        for (uint32_t i = 0; i < count; i++) {
+            const VertexAttrib& a = attribs[i];
+            glVertexAttribPointer(a.location, a.components, a.type, a.normalized ? GL_TRUE : GL_FALSE, stride, (void*)(uintptr_t)a.offset);
+            glEnableVertexAttribArray(a.location);
+        }
+    }
+};
+
+// maps stored attribute values back to object space, the identity for the float layouts
+struct VertexDecode {
+    float posOffset[3] = { 0.0f, 0.0f, 0.0f };
+    float posScale[3] = { 1.0f, 1.0f, 1.0f };
+    float uvOffset[2] = { 0.0f, 0.0f };
+    float uvScale[2] = { 1.0f, 1.0f };
+};
+
+// the createObj layouts: position, then an optional color/normal, then optional uv, all tightly packed floats
+VertexLayout objLayout(bool hasColor, bool hasTexture) {
+    VertexLayout layout;
+    uint32_t offset = 0;
+    layout.add(0, 3, GL_FLOAT, false, offset);
+    offset += 3 * sizeof(float);
+    if (hasColor) {
+        layout.add(1, 3, GL_FLOAT, false, offset);
+        offset += 3 * sizeof(float);
+    }
+    if (hasTexture) {
+        layout.add(hasColor ? 2 : 1, 2, GL_FLOAT, false, offset);
+        offset += 2 * sizeof(float);
+    }
+    layout.stride = offset;
+    return layout;
+}
+
+#endif
\ No newline at end of file